@@ -0,0 +1,27 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/corel.dir/src/bitmap.c.o"
+  "CMakeFiles/corel.dir/src/bitmap.c.o.d"
+  "CMakeFiles/corel.dir/src/bloom.c.o"
+  "CMakeFiles/corel.dir/src/bloom.c.o.d"
+  "CMakeFiles/corel.dir/src/classify.c.o"
+  "CMakeFiles/corel.dir/src/classify.c.o.d"
+  "CMakeFiles/corel.dir/src/graph.c.o"
+  "CMakeFiles/corel.dir/src/graph.c.o.d"
+  "CMakeFiles/corel.dir/src/io.c.o"
+  "CMakeFiles/corel.dir/src/io.c.o.d"
+  "CMakeFiles/corel.dir/src/main.c.o"
+  "CMakeFiles/corel.dir/src/main.c.o.d"
+  "CMakeFiles/corel.dir/src/oidmap.c.o"
+  "CMakeFiles/corel.dir/src/oidmap.c.o.d"
+  "CMakeFiles/corel.dir/src/pack.c.o"
+  "CMakeFiles/corel.dir/src/pack.c.o.d"
+  "CMakeFiles/corel.dir/src/semver.c.o"
+  "CMakeFiles/corel.dir/src/semver.c.o.d"
+  "corel"
+  "corel.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/corel.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,29 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/corel_classify_test.dir/src/bitmap.c.o"
+  "CMakeFiles/corel_classify_test.dir/src/bitmap.c.o.d"
+  "CMakeFiles/corel_classify_test.dir/src/bloom.c.o"
+  "CMakeFiles/corel_classify_test.dir/src/bloom.c.o.d"
+  "CMakeFiles/corel_classify_test.dir/src/classify.c.o"
+  "CMakeFiles/corel_classify_test.dir/src/classify.c.o.d"
+  "CMakeFiles/corel_classify_test.dir/src/graph.c.o"
+  "CMakeFiles/corel_classify_test.dir/src/graph.c.o.d"
+  "CMakeFiles/corel_classify_test.dir/src/io.c.o"
+  "CMakeFiles/corel_classify_test.dir/src/io.c.o.d"
+  "CMakeFiles/corel_classify_test.dir/src/oidmap.c.o"
+  "CMakeFiles/corel_classify_test.dir/src/oidmap.c.o.d"
+  "CMakeFiles/corel_classify_test.dir/src/pack.c.o"
+  "CMakeFiles/corel_classify_test.dir/src/pack.c.o.d"
+  "CMakeFiles/corel_classify_test.dir/src/semver.c.o"
+  "CMakeFiles/corel_classify_test.dir/src/semver.c.o.d"
+  "CMakeFiles/corel_classify_test.dir/tests/classify_test.c.o"
+  "CMakeFiles/corel_classify_test.dir/tests/classify_test.c.o.d"
+  "CMakeFiles/corel_classify_test.dir/tests/test.c.o"
+  "CMakeFiles/corel_classify_test.dir/tests/test.c.o.d"
+  "corel_classify_test"
+  "corel_classify_test.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/corel_classify_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,28 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/bitmap.c" "CMakeFiles/corel_pack_test.dir/src/bitmap.c.o" "gcc" "CMakeFiles/corel_pack_test.dir/src/bitmap.c.o.d"
+  "/root/repo/src/bloom.c" "CMakeFiles/corel_pack_test.dir/src/bloom.c.o" "gcc" "CMakeFiles/corel_pack_test.dir/src/bloom.c.o.d"
+  "/root/repo/src/classify.c" "CMakeFiles/corel_pack_test.dir/src/classify.c.o" "gcc" "CMakeFiles/corel_pack_test.dir/src/classify.c.o.d"
+  "/root/repo/src/graph.c" "CMakeFiles/corel_pack_test.dir/src/graph.c.o" "gcc" "CMakeFiles/corel_pack_test.dir/src/graph.c.o.d"
+  "/root/repo/src/io.c" "CMakeFiles/corel_pack_test.dir/src/io.c.o" "gcc" "CMakeFiles/corel_pack_test.dir/src/io.c.o.d"
+  "/root/repo/src/oidmap.c" "CMakeFiles/corel_pack_test.dir/src/oidmap.c.o" "gcc" "CMakeFiles/corel_pack_test.dir/src/oidmap.c.o.d"
+  "/root/repo/src/pack.c" "CMakeFiles/corel_pack_test.dir/src/pack.c.o" "gcc" "CMakeFiles/corel_pack_test.dir/src/pack.c.o.d"
+  "/root/repo/src/semver.c" "CMakeFiles/corel_pack_test.dir/src/semver.c.o" "gcc" "CMakeFiles/corel_pack_test.dir/src/semver.c.o.d"
+  "/root/repo/tests/pack_test.c" "CMakeFiles/corel_pack_test.dir/tests/pack_test.c.o" "gcc" "CMakeFiles/corel_pack_test.dir/tests/pack_test.c.o.d"
+  "/root/repo/tests/test.c" "CMakeFiles/corel_pack_test.dir/tests/test.c.o" "gcc" "CMakeFiles/corel_pack_test.dir/tests/test.c.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
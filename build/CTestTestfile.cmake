@@ -0,0 +1,28 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo
+# Build directory: /root/repo/build
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
+add_test(bitmap "/root/repo/build/corel_bitmap_test" "/root/repo/tests/make_fixture.sh" "/root/repo/build/tests/bitmap")
+set_tests_properties(bitmap PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;76;add_test;/root/repo/CMakeLists.txt;79;corel_add_test;/root/repo/CMakeLists.txt;0;")
+add_test(bloom "/root/repo/build/corel_bloom_test" "/root/repo/tests/make_fixture.sh" "/root/repo/build/tests/bloom")
+set_tests_properties(bloom PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;76;add_test;/root/repo/CMakeLists.txt;80;corel_add_test;/root/repo/CMakeLists.txt;0;")
+add_test(classify "/root/repo/build/corel_classify_test")
+set_tests_properties(classify PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;76;add_test;/root/repo/CMakeLists.txt;81;corel_add_test;/root/repo/CMakeLists.txt;0;")
+add_test(graph "/root/repo/build/corel_graph_test" "/root/repo/tests/make_fixture.sh" "/root/repo/build/tests/graph")
+set_tests_properties(graph PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;76;add_test;/root/repo/CMakeLists.txt;82;corel_add_test;/root/repo/CMakeLists.txt;0;")
+add_test(pack "/root/repo/build/corel_pack_test" "/root/repo/tests/make_fixture.sh" "/root/repo/build/tests/pack")
+set_tests_properties(pack PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;76;add_test;/root/repo/CMakeLists.txt;83;corel_add_test;/root/repo/CMakeLists.txt;0;")
+add_test(semver "/root/repo/build/corel_semver_test")
+set_tests_properties(semver PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;76;add_test;/root/repo/CMakeLists.txt;84;corel_add_test;/root/repo/CMakeLists.txt;0;")
+add_test(describe "sh" "/root/repo/tests/describe_test.sh" "/root/repo/build/corel" "/root/repo/build/tests/describe")
+set_tests_properties(describe PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;88;add_test;/root/repo/CMakeLists.txt;91;corel_add_script_test;/root/repo/CMakeLists.txt;0;")
+add_test(push "sh" "/root/repo/tests/push_test.sh" "/root/repo/build/corel" "/root/repo/build/tests/push")
+set_tests_properties(push PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;88;add_test;/root/repo/CMakeLists.txt;92;corel_add_script_test;/root/repo/CMakeLists.txt;0;")
+add_test(race "sh" "/root/repo/tests/race_test.sh" "/root/repo/build/corel" "/root/repo/build/tests/race")
+set_tests_properties(race PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;88;add_test;/root/repo/CMakeLists.txt;93;corel_add_script_test;/root/repo/CMakeLists.txt;0;")
+add_test(remote_tags "sh" "/root/repo/tests/remote_tags_test.sh" "/root/repo/build/corel" "/root/repo/build/tests/remote_tags")
+set_tests_properties(remote_tags PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;88;add_test;/root/repo/CMakeLists.txt;94;corel_add_script_test;/root/repo/CMakeLists.txt;0;")
+add_test(subject "sh" "/root/repo/tests/subject_test.sh" "/root/repo/build/corel" "/root/repo/build/tests/subject")
+set_tests_properties(subject PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;88;add_test;/root/repo/CMakeLists.txt;95;corel_add_script_test;/root/repo/CMakeLists.txt;0;")
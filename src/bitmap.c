@@ -0,0 +1,334 @@
+#include "bitmap.h"
+#include "io.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define BITMAP_MAGIC "BITM"
+#define BITMAP_VERSION 1
+#define BITMAP_HEADER_SIZE (12 + GIT_OID_SHA1_SIZE) // magic, version, flags, entry count, pack checksum
+#define BITMAP_ENTRY_HEADER_SIZE 6                  // commit position in the index, xor offset, flags
+#define EWAH_HEADER_SIZE 8                          // bit count, word count
+#define RIDX_MAGIC "RIDX"
+#define RIDX_HEADER_SIZE 12
+
+typedef struct {
+    u_int64_t *words;
+    size_t len;
+} corel_bitset;
+
+static void corel_bitset_init(corel_bitset *set, size_t bits) {
+    set->len = (bits + 63) / 64;
+    set->words = calloc(set->len ? set->len : 1, sizeof(u_int64_t));
+}
+
+static bool corel_bitset_get(corel_bitset *set, u_int32_t bit) {
+    return set->words[bit / 64] & ((u_int64_t)1 << (bit % 64));
+}
+
+static void corel_bitset_set(corel_bitset *set, u_int32_t bit) {
+    set->words[bit / 64] |= (u_int64_t)1 << (bit % 64);
+}
+
+/* Bytes an EWAH bitmap takes up, 0 if it does not fit into avail */
+static size_t corel_ewah_size(const unsigned char *data, size_t avail) {
+    if (avail < EWAH_HEADER_SIZE) {
+        return 0;
+    }
+    size_t size = EWAH_HEADER_SIZE + (size_t)corel_be32(data + 4) * 8 + 4;
+    return size <= avail ? size : 0;
+}
+
+/* Decodes the run length words of an EWAH bitmap and XORs the result into out. Returns 1 if it is malformed */
+static int corel_ewah_xor(corel_bitset *out, const unsigned char *data) {
+    u_int32_t count = corel_be32(data + 4);
+    const unsigned char *words = data + EWAH_HEADER_SIZE;
+    size_t pos = 0;
+    for (u_int32_t i = 0; i < count;) {
+        u_int64_t marker = corel_be64(words + (size_t)i++ * 8);
+        u_int64_t run = (marker >> 1) & 0xffffffff;
+        u_int64_t literals = marker >> 33;
+        if (pos + run + literals > out->len || i + literals > count) {
+            return 1;
+        }
+        if (marker & 1) {
+            for (u_int64_t j = 0; j < run; j++) {
+                out->words[pos++] ^= ~(u_int64_t)0;
+            }
+        } else {
+            pos += run;
+        }
+        for (u_int64_t j = 0; j < literals; j++) {
+            out->words[pos++] ^= corel_be64(words + (size_t)i++ * 8);
+        }
+    }
+    return 0;
+}
+
+
+void corel_bitmap_free(corel_bitmap *bitmap) {
+    if (!bitmap) {
+        return;
+    }
+    munmap((void *)bitmap->map, bitmap->map_size);
+    free(bitmap->order);
+    free(bitmap->entries);
+    corel_oidmap_free(&bitmap->by_commit);
+    free(bitmap);
+}
+
+static int corel_offset_cmp(const void *o1, const void *o2) {
+    const u_int64_t *offset1 = o1;
+    const u_int64_t *offset2 = o2;
+    return (*offset1 > *offset2) - (*offset1 < *offset2);
+}
+
+/* Pack order is offset order. git writes it down in a .rev file these days, older packs get it sorted */
+static u_int32_t *corel_pack_order(corel_pack *pack) {
+    u_int32_t *order = malloc((pack->count ? pack->count : 1) * sizeof(u_int32_t));
+    size_t stem = strlen(pack->pack_path) - strlen("pack");
+    char path[stem + sizeof("rev")];
+    memcpy(path, pack->pack_path, stem);
+    strcpy(path + stem, "rev");
+
+    size_t size = 0;
+    const unsigned char *rev = corel_mmap_file(path, &size);
+    if (rev && size >= RIDX_HEADER_SIZE + (size_t)pack->count * 4 && memcmp(rev, RIDX_MAGIC, 4) == 0) {
+        // A position past the index would be read as an OID, sort the offsets instead
+        bool valid = true;
+        for (u_int32_t i = 0; i < pack->count && valid; i++) {
+            order[i] = corel_be32(rev + RIDX_HEADER_SIZE + (size_t)i * 4);
+            valid = order[i] < pack->count;
+        }
+        if (valid) {
+            munmap((void *)rev, size);
+            return order;
+        }
+    }
+    if (rev) {
+        munmap((void *)rev, size);
+    }
+
+    // Offsets fit into 40 bits for any pack git can write, that leaves the lower bits for the index position. A larger
+    // one comes from a broken index, leave those packs to libgit2
+    if (pack->count >= (1 << 24)) {
+        free(order);
+        return NULL;
+    }
+    u_int64_t *keyed = malloc((pack->count ? pack->count : 1) * sizeof(u_int64_t));
+    for (u_int32_t i = 0; i < pack->count; i++) {
+        u_int64_t offset = corel_pack_offset(pack, i);
+        if (offset >> 40) {
+            free(keyed);
+            free(order);
+            return NULL;
+        }
+        keyed[i] = offset << 24 | i;
+    }
+    qsort(keyed, pack->count, sizeof(u_int64_t), corel_offset_cmp);
+    for (u_int32_t i = 0; i < pack->count; i++) {
+        order[i] = keyed[i] & 0xffffff;
+    }
+    free(keyed);
+    return order;
+}
+
+corel_bitmap *corel_bitmap_open(corel_pack *pack) {
+    size_t stem = strlen(pack->pack_path) - strlen("pack");
+    char path[stem + sizeof("bitmap")];
+    memcpy(path, pack->pack_path, stem);
+    strcpy(path + stem, "bitmap");
+
+    size_t size = 0;
+    const unsigned char *map = corel_mmap_file(path, &size);
+    if (!map) {
+        return NULL;
+    }
+    corel_bitmap *bitmap = calloc(1, sizeof(corel_bitmap));
+    bitmap->pack = pack;
+    bitmap->map = map;
+    bitmap->map_size = size;
+    corel_oidmap_init(&bitmap->by_commit, 16);
+
+    // The bitmap has to belong to exactly this pack, the idx ends with the checksums of the pack and of itself
+    const unsigned char *pack_checksum = pack->idx + pack->idx_size - 2 * GIT_OID_SHA1_SIZE;
+    if (size < BITMAP_HEADER_SIZE || memcmp(map, BITMAP_MAGIC, 4) != 0 || ((map[4] << 8) | map[5]) != BITMAP_VERSION ||
+        memcmp(map + 12, pack_checksum, GIT_OID_SHA1_SIZE) != 0) {
+        corel_bitmap_free(bitmap);
+        return NULL;
+    }
+
+    // The type bitmaps come first, only the commit one is of interest
+    const unsigned char *data = map + BITMAP_HEADER_SIZE;
+    const unsigned char *end = map + size;
+    for (int type = 0; type < 4; type++) {
+        size_t ewah = corel_ewah_size(data, end - data);
+        if (!ewah) {
+            corel_bitmap_free(bitmap);
+            return NULL;
+        }
+        if (type == 0) {
+            bitmap->commits = data;
+        }
+        data += ewah;
+    }
+
+    bitmap->entry_count = corel_be32(map + 8);
+    bitmap->entries = malloc((bitmap->entry_count ? bitmap->entry_count : 1) * sizeof(unsigned char *));
+    for (u_int32_t i = 0; i < bitmap->entry_count; i++) {
+        size_t ewah = end - data > BITMAP_ENTRY_HEADER_SIZE ? corel_ewah_size(data + BITMAP_ENTRY_HEADER_SIZE, end - data - BITMAP_ENTRY_HEADER_SIZE) : 0;
+        u_int32_t pos = ewah ? corel_be32(data) : pack->count;
+        if (pos >= pack->count || data[4] > i) {
+            corel_bitmap_free(bitmap);
+            return NULL;
+        }
+        git_oid commit;
+        git_oid_fromraw(&commit, corel_pack_oid(pack, pos));
+        corel_oidmap_put(&bitmap->by_commit, &commit, i);
+        bitmap->entries[i] = data;
+        data += BITMAP_ENTRY_HEADER_SIZE + ewah;
+    }
+
+    if (!(bitmap->order = corel_pack_order(pack))) {
+        corel_bitmap_free(bitmap);
+        return NULL;
+    }
+    return bitmap;
+}
+
+/* XORs the reachability of entry i into out, including the chain of bitmaps it was XORed against */
+static int corel_bitmap_entry_xor(corel_bitmap *bitmap, u_int32_t i, corel_bitset *out) {
+    const unsigned char *entry = bitmap->entries[i];
+    if (corel_ewah_xor(out, entry + BITMAP_ENTRY_HEADER_SIZE) != 0) {
+        return 1;
+    }
+    return entry[4] ? corel_bitmap_entry_xor(bitmap, i - entry[4], out) : 0;
+}
+
+/* Position of the object in pack order, found by its offset. -1 if it is not in the pack */
+static int64_t corel_bitmap_position(corel_bitmap *bitmap, const git_oid *oid) {
+    int64_t idx_pos = corel_pack_find(bitmap->pack, oid);
+    if (idx_pos < 0) {
+        return -1;
+    }
+    u_int64_t offset = corel_pack_offset(bitmap->pack, idx_pos);
+    u_int32_t lo = 0;
+    u_int32_t hi = bitmap->pack->count;
+    while (lo < hi) {
+        u_int32_t mid = lo + (hi - lo) / 2;
+        u_int64_t current = corel_pack_offset(bitmap->pack, bitmap->order[mid]);
+        if (current == offset) {
+            return mid;
+        }
+        if (current < offset) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return -1;
+}
+
+/* Marks everything reachable from start. Walking only goes as far as the next commit with a bitmap, which covers the rest
+ * in one go. Commits that are not in the pack (newer than it) end up in outside instead. */
+static int corel_bitmap_reach(corel_bitmap *bitmap, git_repository *repository, const git_oid *start, corel_bitset *out, corel_oidmap *outside) {
+    size_t stack_len = 1;
+    size_t stack_capacity = 64;
+    git_oid *stack = malloc(stack_capacity * sizeof(git_oid));
+    git_oid_cpy(&stack[0], start);
+
+    int err = 0;
+    while (stack_len > 0 && err == 0) {
+        git_oid oid = stack[--stack_len];
+        int64_t pos = corel_bitmap_position(bitmap, &oid);
+        if (pos >= 0) {
+            if (corel_bitset_get(out, pos)) {
+                continue;
+            }
+            u_int64_t *entry = corel_oidmap_get(&bitmap->by_commit, &oid);
+            if (entry) {
+                corel_bitset reachable;
+                corel_bitset_init(&reachable, bitmap->pack->count);
+                err = corel_bitmap_entry_xor(bitmap, *entry, &reachable);
+                for (size_t w = 0; w < out->len; w++) {
+                    out->words[w] |= reachable.words[w];
+                }
+                free(reachable.words);
+                continue;
+            }
+            corel_bitset_set(out, pos);
+        } else if (corel_oidmap_put(outside, &oid, 0)) {
+            continue;
+        }
+
+        git_commit *commit;
+        if (git_commit_lookup(&commit, repository, &oid) != 0) {
+            err = 1;
+            break;
+        }
+        for (unsigned int i = 0; i < git_commit_parentcount(commit); i++) {
+            if (stack_len == stack_capacity) {
+                stack_capacity *= 2;
+                stack = realloc(stack, stack_capacity * sizeof(git_oid));
+            }
+            git_oid_cpy(&stack[stack_len++], git_commit_parent_id(commit, i));
+        }
+        git_commit_free(commit);
+    }
+    free(stack);
+    return err;
+}
+
+int64_t corel_bitmap_walk(corel_bitmap *bitmap, git_repository *repository, const git_oid *head, git_commit *since, const git_oid *resume,
+                          corel_commit_cb callback, void *payload) {
+    corel_bitset wanted;
+    corel_bitset released;
+    corel_bitset commits;
+    corel_oidmap wanted_outside;
+    corel_oidmap released_outside;
+    corel_bitset_init(&wanted, bitmap->pack->count);
+    corel_bitset_init(&released, bitmap->pack->count);
+    corel_bitset_init(&commits, bitmap->pack->count);
+    corel_oidmap_init(&wanted_outside, 16);
+    corel_oidmap_init(&released_outside, 16);
+
+    int64_t count = -1;
+    if (corel_ewah_xor(&commits, bitmap->commits) != 0 || corel_bitmap_reach(bitmap, repository, head, &wanted, &wanted_outside) != 0 ||
+        (since && corel_bitmap_reach(bitmap, repository, git_commit_id(since), &released, &released_outside) != 0) ||
+        (resume && corel_bitmap_reach(bitmap, repository, resume, &released, &released_outside) != 0)) {
+        goto cleanup;
+    }
+
+    count = 0;
+    for (size_t i = 0; i < wanted_outside.capacity; i++) {
+        if (!wanted_outside.used[i] || corel_oidmap_get(&released_outside, &wanted_outside.keys[i])) {
+            continue;
+        }
+        count++;
+        if (callback && callback(&wanted_outside.keys[i], payload) != 0) {
+            goto cleanup;
+        }
+    }
+    for (size_t w = 0; w < wanted.len; w++) {
+        u_int64_t word = wanted.words[w] & ~released.words[w] & commits.words[w];
+        while (word) {
+            u_int32_t pos = w * 64 + __builtin_ctzll(word);
+            word &= word - 1;
+            git_oid oid;
+            git_oid_fromraw(&oid, corel_pack_oid(bitmap->pack, bitmap->order[pos]));
+            count++;
+            if (callback && callback(&oid, payload) != 0) {
+                goto cleanup;
+            }
+        }
+    }
+
+cleanup:
+    free(wanted.words);
+    free(released.words);
+    free(commits.words);
+    corel_oidmap_free(&wanted_outside);
+    corel_oidmap_free(&released_outside);
+    return count;
+}
@@ -0,0 +1,35 @@
+#ifndef COREL_BITMAP_H
+#define COREL_BITMAP_H
+
+#include "git2/commit.h"
+#include "git2/oid.h"
+#include "git2/repository.h"
+#include "graph.h"
+#include "oidmap.h"
+#include "pack.h"
+
+/* The reachability bitmaps git keeps next to a pack (repack -b, gc on servers). Every selected commit has a bitmap of
+ * everything it can reach, with one bit per object in pack order. The bitmaps are XORed against earlier ones to save
+ * space. */
+typedef struct {
+    corel_pack *pack;
+    const unsigned char *map;
+    size_t map_size;
+    u_int32_t *order; // Pack order -> position in the index
+    const unsigned char *commits;
+    u_int32_t entry_count;
+    const unsigned char **entries;
+    corel_oidmap by_commit; // Commit -> entry
+} corel_bitmap;
+
+/* NULL if the pack has no bitmap or it does not belong to the pack */
+corel_bitmap *corel_bitmap_open(corel_pack *pack);
+void corel_bitmap_free(corel_bitmap *bitmap);
+
+/* Walks since..head minus everything resume reaches, like corel_graph_walk. The range is the AND-NOT of the reachability
+ * bitmaps of both sides and only the commits in it are handed out, in no particular order. Commits newer than the pack
+ * are walked one by one until they run into it. Returns -1 without calling back if the bitmaps cannot answer it. */
+int64_t corel_bitmap_walk(corel_bitmap *bitmap, git_repository *repository, const git_oid *head, git_commit *since, const git_oid *resume,
+                          corel_commit_cb callback, void *payload);
+
+#endif
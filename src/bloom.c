@@ -0,0 +1,223 @@
+#include "bloom.h"
+#include "git2/commit.h"
+#include "git2/diff.h"
+#include "git2/tree.h"
+#include "io.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/param.h>
+
+#define BLOOM_MAGIC "CRLB"
+#define BLOOM_VERSION 1
+#define BLOOM_HEADER_SIZE (16 + GIT_OID_SHA1_SIZE) // magic, version, hashes, commit count, tip
+#define BLOOM_HASHES 7
+#define BLOOM_BITS_PER_ENTRY 10
+#define BLOOM_MAX_CHANGES 512 // Commits changing more paths than that get a filter that matches everything
+#define BLOOM_MATCH_ALL 0xff
+
+
+static void corel_bloom_hashes(const char *path, size_t len, u_int32_t *h1, u_int32_t *h2) {
+    u_int64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (unsigned char)path[i]) * 0x100000001b3ULL;
+    }
+    *h1 = hash;
+    *h2 = (hash >> 32) | 1;
+}
+
+static void corel_bloom_add(unsigned char *filter, u_int32_t len, const char *path, size_t path_len) {
+    u_int32_t h1;
+    u_int32_t h2;
+    corel_bloom_hashes(path, path_len, &h1, &h2);
+    for (u_int32_t i = 0; i < BLOOM_HASHES; i++) {
+        u_int64_t bit = (h1 + (u_int64_t)i * h2) % ((u_int64_t)len * 8);
+        filter[bit / 8] |= 1 << (bit % 8);
+    }
+}
+
+static bool corel_bloom_contains(const unsigned char *filter, u_int32_t len, const char *path) {
+    u_int32_t h1;
+    u_int32_t h2;
+    corel_bloom_hashes(path, strlen(path), &h1, &h2);
+    for (u_int32_t i = 0; i < BLOOM_HASHES; i++) {
+        u_int64_t bit = (h1 + (u_int64_t)i * h2) % ((u_int64_t)len * 8);
+        if (!(filter[bit / 8] & (1 << (bit % 8)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int64_t corel_bloom_find(corel_bloom *bloom, const git_oid *oid) {
+    u_int32_t lo = 0;
+    u_int32_t hi = bloom->count;
+    while (lo < hi) {
+        u_int32_t mid = lo + (hi - lo) / 2;
+        int cmp = memcmp(bloom->oids + (size_t)mid * GIT_OID_SHA1_SIZE, oid->id, GIT_OID_SHA1_SIZE);
+        if (cmp == 0) {
+            return mid;
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return -1;
+}
+
+int corel_bloom_query(corel_bloom *bloom, const git_oid *oid, const char *path) {
+    int64_t pos = bloom ? corel_bloom_find(bloom, oid) : -1;
+    if (pos < 0) {
+        return -1;
+    }
+    u_int32_t start = pos == 0 ? 0 : corel_be32(bloom->ends + (size_t)(pos - 1) * 4);
+    u_int32_t end = corel_be32(bloom->ends + (size_t)pos * 4);
+    if (end <= start || end > bloom->filters_size) {
+        return -1;
+    }
+    return corel_bloom_contains(bloom->filters + start, end - start, path);
+}
+
+void corel_bloom_unmap(corel_bloom *bloom) {
+    if (bloom->map) {
+        munmap((void *)bloom->map, bloom->map_size);
+    }
+    bloom->map = NULL;
+    bloom->count = 0;
+}
+
+int corel_bloom_map(corel_bloom *bloom) {
+    bloom->map = corel_mmap_file(bloom->path, &bloom->map_size);
+    if (!bloom->map) {
+        return 0;
+    }
+    const unsigned char *map = bloom->map;
+    u_int32_t count = bloom->map_size >= BLOOM_HEADER_SIZE ? corel_be32(map + 12) : 0;
+    size_t tables = BLOOM_HEADER_SIZE + (size_t)count * (GIT_OID_SHA1_SIZE + 4);
+    if (bloom->map_size < BLOOM_HEADER_SIZE || memcmp(map, BLOOM_MAGIC, 4) != 0 || corel_be32(map + 4) != BLOOM_VERSION ||
+        corel_be32(map + 8) != BLOOM_HASHES || bloom->map_size < tables) {
+        corel_bloom_unmap(bloom);
+        return 1;
+    }
+    bloom->count = count;
+    bloom->oids = map + BLOOM_HEADER_SIZE;
+    bloom->ends = bloom->oids + (size_t)count * GIT_OID_SHA1_SIZE;
+    bloom->filters = bloom->ends + (size_t)count * 4;
+    bloom->filters_size = bloom->map_size - tables;
+    return 0;
+}
+
+int corel_bloom_compute(corel_bloom_entry *entry, git_repository *repository, const git_oid *oid) {
+    git_commit *commit = NULL;
+    git_commit *parent = NULL;
+    git_tree *tree = NULL;
+    git_tree *parent_tree = NULL;
+    git_diff *diff = NULL;
+    int err = git_commit_lookup(&commit, repository, oid) != 0 || git_commit_tree(&tree, commit) != 0 ||
+              (git_commit_parentcount(commit) > 0 && (git_commit_parent(&parent, commit, 0) != 0 || git_commit_tree(&parent_tree, parent) != 0)) ||
+              git_diff_tree_to_tree(&diff, repository, parent_tree, tree, NULL) != 0;
+
+    if (err == 0) {
+        git_oid_cpy(&entry->oid, oid);
+        size_t deltas = git_diff_num_deltas(diff);
+        size_t paths = 0;
+        for (size_t i = 0; i < deltas && deltas <= BLOOM_MAX_CHANGES; i++) {
+            for (const char *c = git_diff_get_delta(diff, i)->new_file.path; *c; c++) {
+                paths += *c == '/';
+            }
+            paths++;
+        }
+        if (deltas > BLOOM_MAX_CHANGES) {
+            entry->len = 1;
+            entry->filter = malloc(1);
+            entry->filter[0] = BLOOM_MATCH_ALL;
+        } else {
+            entry->len = MAX((paths * BLOOM_BITS_PER_ENTRY + 7) / 8, 8);
+            entry->filter = calloc(entry->len, 1);
+        }
+        for (size_t i = 0; i < deltas && deltas <= BLOOM_MAX_CHANGES; i++) {
+            const char *path = git_diff_get_delta(diff, i)->new_file.path;
+            for (const char *c = path;; c++) {
+                if (*c == '/' || *c == '\0') {
+                    corel_bloom_add(entry->filter, entry->len, path, c - path);
+                }
+                if (*c == '\0') {
+                    break;
+                }
+            }
+        }
+    }
+    git_diff_free(diff);
+    git_tree_free(parent_tree);
+    git_tree_free(tree);
+    git_commit_free(parent);
+    git_commit_free(commit);
+    return err;
+}
+
+static int corel_bloom_entry_cmp(const void *e1, const void *e2) {
+    const corel_bloom_entry *entry1 = e1;
+    const corel_bloom_entry *entry2 = e2;
+    return git_oid_cmp(&entry1->oid, &entry2->oid);
+}
+
+int corel_bloom_write(corel_bloom *bloom, corel_bloom_entry *added, size_t added_len, const git_oid *tip, FILE *out) {
+    qsort(added, added_len, sizeof(corel_bloom_entry), corel_bloom_entry_cmp);
+    size_t total = bloom->count + added_len;
+    u_int32_t *old_pos = malloc((total ? total : 1) * sizeof(u_int32_t));
+    corel_bloom_entry **new_pos = malloc((total ? total : 1) * sizeof(corel_bloom_entry *));
+    size_t old = 0;
+    size_t new = 0;
+    size_t len = 0;
+    while (old < bloom->count || new < added_len) {
+        int cmp = old == bloom->count ? 1 : (new == added_len ? -1 : memcmp(bloom->oids + old * GIT_OID_SHA1_SIZE, added[new].oid.id, GIT_OID_SHA1_SIZE));
+        new_pos[len] = cmp < 0 ? NULL : &added[new];
+        old_pos[len] = cmp <= 0 ? old : 0;
+        old += cmp <= 0;
+        new += cmp >= 0;
+        len++;
+    }
+
+    unsigned char header[BLOOM_HEADER_SIZE];
+    memcpy(header, BLOOM_MAGIC, 4);
+    corel_put_be32(header + 4, BLOOM_VERSION);
+    corel_put_be32(header + 8, BLOOM_HASHES);
+    corel_put_be32(header + 12, len);
+    memcpy(header + 16, tip->id, GIT_OID_SHA1_SIZE);
+    fwrite(header, 1, sizeof(header), out);
+
+    for (size_t i = 0; i < len; i++) {
+        fwrite(new_pos[i] ? new_pos[i]->oid.id : bloom->oids + (size_t)old_pos[i] * GIT_OID_SHA1_SIZE, 1, GIT_OID_SHA1_SIZE, out);
+    }
+    u_int32_t end = 0;
+    for (size_t i = 0; i < len; i++) {
+        u_int32_t start = old_pos[i] == 0 ? 0 : corel_be32(bloom->ends + (size_t)(old_pos[i] - 1) * 4);
+        end += new_pos[i] ? new_pos[i]->len : corel_be32(bloom->ends + (size_t)old_pos[i] * 4) - start;
+        unsigned char be[4];
+        corel_put_be32(be, end);
+        fwrite(be, 1, 4, out);
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (new_pos[i]) {
+            fwrite(new_pos[i]->filter, 1, new_pos[i]->len, out);
+        } else {
+            u_int32_t start = old_pos[i] == 0 ? 0 : corel_be32(bloom->ends + (size_t)(old_pos[i] - 1) * 4);
+            fwrite(bloom->filters + start, 1, corel_be32(bloom->ends + (size_t)old_pos[i] * 4) - start, out);
+        }
+    }
+    free(old_pos);
+    free(new_pos);
+    return ferror(out) != 0;
+}
+
+void corel_bloom_free(corel_bloom *bloom) {
+    if (!bloom) {
+        return;
+    }
+    corel_bloom_unmap(bloom);
+    free(bloom->path);
+    free(bloom);
+}
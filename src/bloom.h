@@ -0,0 +1,42 @@
+#ifndef COREL_BLOOM_H
+#define COREL_BLOOM_H
+
+#include "git2/oid.h"
+#include "git2/repository.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/types.h>
+
+/* One changed-path Bloom filter per commit, the same idea as the BDAT chunk of git's commit-graph. A commit's filter
+ * has every path it changed against its first parent, plus all directories above them. The file has a sorted OID table,
+ * the end offset of every filter and then the filters, and it remembers the HEAD it was last brought up to date at. */
+typedef struct {
+    char *path;
+    const unsigned char *map;
+    size_t map_size;
+    u_int32_t count;
+    const unsigned char *oids;
+    const unsigned char *ends;
+    const unsigned char *filters;
+    size_t filters_size;
+} corel_bloom;
+
+typedef struct {
+    git_oid oid;
+    unsigned char *filter;
+    u_int32_t len;
+} corel_bloom_entry;
+
+/* Maps the file at bloom->path. A missing file leaves the index empty, so does one that is unusable, which returns 1 */
+int corel_bloom_map(corel_bloom *bloom);
+void corel_bloom_unmap(corel_bloom *bloom);
+void corel_bloom_free(corel_bloom *bloom);
+int64_t corel_bloom_find(corel_bloom *bloom, const git_oid *oid);
+/* 0 if the commit definitely did not change path against its first parent, 1 if it might have, -1 if it has no filter */
+int corel_bloom_query(corel_bloom *bloom, const git_oid *oid, const char *path);
+/* Diffs the commit against its first parent. Only trees are compared, the blobs are never read */
+int corel_bloom_compute(corel_bloom_entry *entry, git_repository *repository, const git_oid *oid);
+/* Merges the new filters into the mapped ones and writes the whole index to out. Sorts added. Returns 1 if writing failed */
+int corel_bloom_write(corel_bloom *bloom, corel_bloom_entry *added, size_t added_len, const git_oid *tip, FILE *out);
+
+#endif
@@ -0,0 +1,230 @@
+#include "classify.h"
+#include <regex.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/types.h>
+
+#ifdef COREL_HAVE_PCRE2
+#define PCRE2_CODE_UNIT_WIDTH 8
+#include <pcre2.h>
+#endif
+
+static regex_t major_regex = {0};
+static regex_t minor_regex = {0};
+static regex_t patch_regex = {0};
+static bool posix_compiled = false;
+#ifdef COREL_HAVE_PCRE2
+static pcre2_code *combined_pcre = NULL;
+static __thread pcre2_match_data *combined_match = NULL; // Match data is scratch space, every thread needs its own
+static uint32_t combined_major_group = 0;
+static uint32_t combined_minor_group = 0;
+static bool combined_jit = false;
+#endif
+
+#define COMPILE_REGEX(target, regex)                                                                                                                           \
+    if (regcomp(&target, regex, REG_EXTENDED | REG_ICASE) != 0) {                                                                                              \
+        return 1;                                                                                                                                              \
+    };
+
+int corel_posix_compile(void) {
+    COMPILE_REGEX(major_regex, MAJOR_REGEX);
+    COMPILE_REGEX(minor_regex, MINOR_REGEX);
+    COMPILE_REGEX(patch_regex, PATCH_REGEX);
+    posix_compiled = true;
+    return 0;
+}
+
+#ifdef COREL_HAVE_PCRE2
+int corel_pcre_compile(void) {
+    int err;
+    PCRE2_SIZE err_offset;
+    combined_pcre = pcre2_compile((PCRE2_SPTR)COMBINED_REGEX, PCRE2_ZERO_TERMINATED, PCRE2_CASELESS | PCRE2_DOTALL, &err, &err_offset, NULL);
+    if (!combined_pcre) {
+        return 1;
+    }
+    combined_jit = pcre2_jit_compile(combined_pcre, PCRE2_JIT_COMPLETE) == 0;
+    combined_major_group = pcre2_substring_number_from_name(combined_pcre, (PCRE2_SPTR) "major");
+    combined_minor_group = pcre2_substring_number_from_name(combined_pcre, (PCRE2_SPTR) "minor");
+    combined_match = pcre2_match_data_create_from_pattern(combined_pcre, NULL);
+    return 0;
+}
+
+void corel_pcre_match_free(void) {
+    pcre2_match_data_free(combined_match);
+    combined_match = NULL;
+}
+
+void corel_pcre_free(void) {
+    corel_pcre_match_free();
+    pcre2_code_free(combined_pcre);
+    combined_pcre = NULL;
+}
+
+static COREL_RELEASE_BUMP corel_pcre_analyze(const char *commit_message) {
+    if (!combined_match) {
+        combined_match = pcre2_match_data_create_from_pattern(combined_pcre, NULL);
+    }
+    size_t len = strlen(commit_message);
+    int rc = combined_jit ? pcre2_jit_match(combined_pcre, (PCRE2_SPTR)commit_message, len, 0, 0, combined_match, NULL)
+                          : pcre2_match(combined_pcre, (PCRE2_SPTR)commit_message, len, 0, 0, combined_match, NULL);
+    if (rc < 0) {
+        return PATCH;
+    }
+    PCRE2_SIZE *ovector = pcre2_get_ovector_pointer(combined_match);
+    if (ovector[2 * combined_major_group] != PCRE2_UNSET) {
+        return MAJOR;
+    }
+    if (ovector[2 * combined_minor_group] != PCRE2_UNSET) {
+        return MINOR;
+    }
+    return PATCH;
+}
+#endif
+
+#define KEYWORD_AUTOMATON_MAX_NODES 128
+#define KEYWORD_AUTOMATON_MAX_CLASSES 32
+
+/* A trie over the keywords of all rules with one transition table row per node. Characters are folded into classes
+ * first: both ASCII cases of a letter share one, characters outside of the keywords get class 0 which ends the scan. */
+typedef struct {
+    u_int8_t char_class[256];
+    u_int8_t next[KEYWORD_AUTOMATON_MAX_NODES][KEYWORD_AUTOMATON_MAX_CLASSES]; // 0 means no transition, the root is 0
+    COREL_RELEASE_BUMP accept[KEYWORD_AUTOMATON_MAX_NODES];
+    u_int8_t classes;
+    u_int8_t nodes;
+} corel_keyword_automaton;
+
+static corel_keyword_automaton keyword_automaton = {0};
+
+static int corel_automaton_add(corel_keyword_automaton *automaton, const char *keyword, COREL_RELEASE_BUMP bump) {
+    u_int8_t node = 0;
+    for (const unsigned char *p = (const unsigned char *)keyword; *p; p++) {
+        unsigned char lower = (*p >= 'A' && *p <= 'Z') ? *p + ('a' - 'A') : *p;
+        unsigned char upper = (*p >= 'a' && *p <= 'z') ? *p - ('a' - 'A') : *p;
+        if (!automaton->char_class[lower]) {
+            if (automaton->classes == KEYWORD_AUTOMATON_MAX_CLASSES) {
+                return 1;
+            }
+            automaton->char_class[lower] = automaton->char_class[upper] = automaton->classes++;
+        }
+
+        u_int8_t class = automaton->char_class[lower];
+        if (!automaton->next[node][class]) {
+            if (automaton->nodes == KEYWORD_AUTOMATON_MAX_NODES) {
+                return 1;
+            }
+            automaton->accept[automaton->nodes] = NONE;
+            automaton->next[node][class] = automaton->nodes++;
+        }
+        node = automaton->next[node][class];
+    }
+    if (bump < automaton->accept[node]) {
+        automaton->accept[node] = bump;
+    }
+    return 0;
+}
+
+int corel_automaton_build(void) {
+#define KEYWORD_ADD_MAJOR(keyword) err |= corel_automaton_add(&keyword_automaton, keyword, MAJOR);
+#define KEYWORD_ADD_MINOR(keyword) err |= corel_automaton_add(&keyword_automaton, keyword, MINOR);
+#define KEYWORD_ADD_PATCH(keyword) err |= corel_automaton_add(&keyword_automaton, keyword, PATCH);
+    int err = 0;
+    memset(&keyword_automaton, 0, sizeof(keyword_automaton));
+    keyword_automaton.classes = 1;
+    keyword_automaton.nodes = 1;
+    keyword_automaton.accept[0] = NONE;
+
+    MAJOR_KEYWORD_LIST(KEYWORD_ADD_MAJOR, )
+    MINOR_KEYWORD_LIST(KEYWORD_ADD_MINOR, )
+    PATCH_KEYWORD_LIST(KEYWORD_ADD_PATCH, )
+    if (err) {
+        keyword_automaton.nodes = 0;
+    }
+    return err;
+}
+
+#define IS_REGEX_SPACE(c) ((c) == ' ' || ((c) >= '\t' && (c) <= '\r'))
+
+/* COMMIT_SUFFIX_REGEX without backtracking. After the colon any character, newlines included, satisfies (.+) */
+static bool corel_commit_suffix_matches(const char *p) {
+    if (IS_REGEX_SPACE(*p)) {
+        p++;
+    }
+
+    // Without a scope both optional spaces may come before the colon
+    const char *colon = IS_REGEX_SPACE(*p) ? p + 1 : p;
+    if (*colon == ':' && colon[1] != '\0') {
+        return true;
+    }
+
+    // Any closing paren can end the scope, so take the first one that is followed by the colon
+    if (*p != '(' || p[1] == '\0') {
+        return false;
+    }
+    for (const char *close = p + 2; *close; close++) {
+        if (*close != ')') {
+            continue;
+        }
+        colon = IS_REGEX_SPACE(close[1]) ? close + 2 : close + 1;
+        if (*colon == ':' && colon[1] != '\0') {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* A single forward scan through the keywords. Whenever a keyword ends, the rest of the message decides if its rule
+ * matches. The strongest matching rule wins, just like the order of the regexes */
+static COREL_RELEASE_BUMP corel_builtin_analyze(const char *commit_message) {
+    COREL_RELEASE_BUMP best = NONE;
+    u_int8_t node = 0;
+    for (const unsigned char *p = (const unsigned char *)commit_message;; p++) {
+        if (keyword_automaton.accept[node] < best && corel_commit_suffix_matches((const char *)p)) {
+            best = keyword_automaton.accept[node];
+        }
+        u_int8_t class = keyword_automaton.char_class[*p];
+        if (!class || !(node = keyword_automaton.next[node][class])) {
+            break;
+        }
+    }
+    return best == NONE ? PATCH : best;
+}
+
+static COREL_RELEASE_BUMP corel_posix_analyze(const char *commit_message) {
+    if (regexec(&major_regex, commit_message, 0, NULL, 0) == 0) {
+        return MAJOR;
+    }
+    if (regexec(&minor_regex, commit_message, 0, NULL, 0) == 0) {
+        return MINOR;
+    }
+    return PATCH;
+}
+
+COREL_RELEASE_BUMP corel_analyze_commit_message(const char *commit_message) {
+    if (keyword_automaton.nodes) {
+        return corel_builtin_analyze(commit_message);
+    }
+#ifdef COREL_HAVE_PCRE2
+    if (combined_pcre) {
+        return corel_pcre_analyze(commit_message);
+    }
+#endif
+    return corel_posix_analyze(commit_message);
+}
+
+COREL_RELEASE_BUMP corel_classifier_analyze(corel_classifier classifier, const char *commit_message) {
+    switch (classifier) {
+    case CLASSIFIER_BUILTIN:
+        return keyword_automaton.nodes ? corel_builtin_analyze(commit_message) : NONE;
+    case CLASSIFIER_PCRE:
+#ifdef COREL_HAVE_PCRE2
+        return combined_pcre ? corel_pcre_analyze(commit_message) : NONE;
+#else
+        return NONE;
+#endif
+    case CLASSIFIER_POSIX:
+        return posix_compiled ? corel_posix_analyze(commit_message) : NONE;
+    }
+    return NONE;
+}
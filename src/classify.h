@@ -0,0 +1,57 @@
+#ifndef COREL_CLASSIFY_H
+#define COREL_CLASSIFY_H
+
+/* The keywords of every rule. SEP goes between two keywords, that way the same list spells the regex alternations and
+ * fills the tables of the builtin classifier */
+#define PATCH_KEYWORD_LIST(KW, SEP)                                                                                                                            \
+    KW("build") SEP KW("chore") SEP KW("ci") SEP KW("docs") SEP KW("env") SEP KW("fix") SEP KW("perf") SEP KW("revert") SEP KW("style") SEP KW("test")
+#define MINOR_KEYWORD_LIST(KW, SEP) KW("feat") SEP KW("refactor")
+#define MAJOR_KEYWORD_LIST(KW, SEP) KW("BREAKING CHANGE")
+
+#define KEYWORD_STR(keyword) keyword
+#define PATCH_KEYWORDS PATCH_KEYWORD_LIST(KEYWORD_STR, "|")
+#define MINOR_KEYWORDS MINOR_KEYWORD_LIST(KEYWORD_STR, "|")
+#define MAJOR_KEYWORDS MAJOR_KEYWORD_LIST(KEYWORD_STR, "|")
+#define COMMIT_SUFFIX_REGEX "\\s?(\\(.+\\))?\\s?:\\s*(.+)"
+
+/* Technically we don't need to keep this, but I will keep it here for documentation purposes */
+#define PATCH_REGEX "^(" PATCH_KEYWORDS ")" COMMIT_SUFFIX_REGEX
+#define MINOR_REGEX "^(" MINOR_KEYWORDS ")" COMMIT_SUFFIX_REGEX
+#define MAJOR_REGEX "^(" MAJOR_KEYWORDS ")" COMMIT_SUFFIX_REGEX
+
+/* All three rules in one pattern. Keywords can share a prefix (refactor and revert), so it is the order of the alternation
+ * that keeps the precedence of the separate regexes: major is tried before minor before patch, and the first one that
+ * matches the whole pattern wins */
+#define COMBINED_REGEX "^(?:(?<major>" MAJOR_KEYWORDS ")|(?<minor>" MINOR_KEYWORDS ")|(?<patch>" PATCH_KEYWORDS "))" COMMIT_SUFFIX_REGEX
+
+typedef enum {
+    CLASSIFIER_BUILTIN,
+    CLASSIFIER_POSIX,
+    CLASSIFIER_PCRE,
+} corel_classifier;
+
+typedef enum {
+    MAJOR,
+    MINOR,
+    PATCH,
+    NONE,
+} COREL_RELEASE_BUMP;
+
+/* POSIX is always compiled, it is what the other classifiers fall back to. Returns 0 on success */
+int corel_posix_compile(void);
+/* Fills the automaton from the keyword lists the regexes are made of. Returns 0 on success */
+int corel_automaton_build(void);
+#ifdef COREL_HAVE_PCRE2
+/* Compiles the combined rules and JITs them if the platform allows it. Returns 0 on success */
+int corel_pcre_compile(void);
+/* Only frees the match data of the calling thread */
+void corel_pcre_match_free(void);
+void corel_pcre_free(void);
+#endif
+
+/* Classifies with the builtin classifier if it was built, PCRE2 if it was compiled and POSIX otherwise */
+COREL_RELEASE_BUMP corel_analyze_commit_message(const char *commit_message);
+/* A single classifier, NONE if it has not been set up. Only the tests pick one, to check them against each other */
+COREL_RELEASE_BUMP corel_classifier_analyze(corel_classifier classifier, const char *commit_message);
+
+#endif
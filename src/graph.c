@@ -0,0 +1,260 @@
+#include "graph.h"
+#include "io.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define GRAPH_FILE "info/commit-graph"
+#define GRAPH_MAGIC "CGPH"
+#define GRAPH_VERSION 1
+#define GRAPH_HASH_SHA1 1
+#define GRAPH_HEADER_SIZE 8
+#define GRAPH_CHUNK_ENTRY_SIZE 12
+#define GRAPH_CHUNK_OIDF 0x4f494446
+#define GRAPH_CHUNK_OIDL 0x4f49444c
+#define GRAPH_CHUNK_CDAT 0x43444154
+#define GRAPH_CHUNK_EDGE 0x45444745
+#define GRAPH_PARENT_NONE 0x70000000
+#define GRAPH_EDGE_OCTOPUS 0x80000000
+#define GRAPH_EDGE_LAST 0x80000000
+
+void corel_graph_free(corel_graph *graph) {
+    if (!graph) {
+        return;
+    }
+    munmap((void *)graph->map, graph->map_size);
+    free(graph);
+}
+
+u_int32_t corel_graph_generation(corel_graph *graph, u_int32_t pos) {
+    return corel_be32(graph->commits + (size_t)pos * GRAPH_CDAT_SIZE + GIT_OID_SHA1_SIZE + 8) >> 2;
+}
+
+u_int64_t corel_graph_date(corel_graph *graph, u_int32_t pos) {
+    const unsigned char *data = graph->commits + (size_t)pos * GRAPH_CDAT_SIZE + GIT_OID_SHA1_SIZE + 8;
+    return ((u_int64_t)(corel_be32(data) & 3) << 32) | corel_be32(data + 4);
+}
+
+corel_graph *corel_graph_open(const char *objects_dir) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s%s", objects_dir, GRAPH_FILE);
+    size_t size = 0;
+    const unsigned char *map = corel_mmap_file(path, &size);
+    if (!map) {
+        return NULL;
+    }
+
+    corel_graph *graph = calloc(1, sizeof(corel_graph));
+    graph->map = map;
+    graph->map_size = size;
+    if (size < GRAPH_HEADER_SIZE || memcmp(map, GRAPH_MAGIC, 4) != 0 || map[4] != GRAPH_VERSION || map[5] != GRAPH_HASH_SHA1 || map[7] != 0 ||
+        size < GRAPH_HEADER_SIZE + (size_t)(map[6] + 1) * GRAPH_CHUNK_ENTRY_SIZE) {
+        corel_graph_free(graph);
+        return NULL;
+    }
+
+    u_int64_t edges_size = 0;
+    for (u_int8_t i = 0; i < map[6]; i++) {
+        const unsigned char *chunk = map + GRAPH_HEADER_SIZE + (size_t)i * GRAPH_CHUNK_ENTRY_SIZE;
+        u_int64_t offset = corel_be64(chunk + 4);
+        u_int64_t end = corel_be64(chunk + 4 + GRAPH_CHUNK_ENTRY_SIZE);
+        if (offset > end || end > size) {
+            corel_graph_free(graph);
+            return NULL;
+        }
+        switch (corel_be32(chunk)) {
+        case GRAPH_CHUNK_OIDF:
+            graph->fanout = map + offset;
+            break;
+        case GRAPH_CHUNK_OIDL:
+            graph->oids = map + offset;
+            graph->count = (end - offset) / GIT_OID_SHA1_SIZE;
+            break;
+        case GRAPH_CHUNK_CDAT:
+            graph->commits = map + offset;
+            break;
+        case GRAPH_CHUNK_EDGE:
+            graph->edges = map + offset;
+            edges_size = end - offset;
+            break;
+        }
+    }
+    graph->edge_count = edges_size / 4;
+    if (!graph->fanout || !graph->oids || !graph->commits || corel_be32(graph->fanout + 255 * 4) != graph->count) {
+        corel_graph_free(graph);
+        return NULL;
+    }
+    for (u_int32_t pos = 0; pos < graph->count; pos++) {
+        if (corel_graph_generation(graph, pos) == 0) {
+            corel_graph_free(graph);
+            return NULL;
+        }
+    }
+    return graph;
+}
+
+const unsigned char *corel_graph_oid(corel_graph *graph, u_int32_t pos) {
+    return graph->oids + (size_t)pos * GIT_OID_SHA1_SIZE;
+}
+
+int64_t corel_graph_find(corel_graph *graph, const git_oid *oid) {
+    u_int32_t lo = oid->id[0] == 0 ? 0 : corel_be32(graph->fanout + (oid->id[0] - 1) * 4);
+    u_int32_t hi = corel_be32(graph->fanout + oid->id[0] * 4);
+    while (lo < hi) {
+        u_int32_t mid = lo + (hi - lo) / 2;
+        int cmp = memcmp(corel_graph_oid(graph, mid), oid->id, GIT_OID_SHA1_SIZE);
+        if (cmp == 0) {
+            return mid;
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return -1;
+}
+
+int corel_graph_parent(corel_graph *graph, u_int32_t pos, u_int32_t n, u_int32_t *out) {
+    const unsigned char *data = graph->commits + (size_t)pos * GRAPH_CDAT_SIZE + GIT_OID_SHA1_SIZE;
+    u_int32_t parent = corel_be32(data + 4 * (n == 0 ? 0 : 1));
+    if (n < 2 && parent == GRAPH_PARENT_NONE) {
+        return 1;
+    }
+    if (!(parent & GRAPH_EDGE_OCTOPUS) || n == 0) {
+        if (n > 1 || parent >= graph->count) {
+            return 1;
+        }
+        *out = parent;
+        return 0;
+    }
+    // Octopus merges keep their second and later parents in the edge list, the last one is marked
+    u_int32_t edge = (parent & ~GRAPH_EDGE_OCTOPUS) + n - 1;
+    if (edge >= graph->edge_count || (n > 1 && (corel_be32(graph->edges + (size_t)(edge - 1) * 4) & GRAPH_EDGE_LAST))) {
+        return 1;
+    }
+    *out = corel_be32(graph->edges + (size_t)edge * 4) & ~GRAPH_EDGE_LAST;
+    return *out < graph->count ? 0 : 1;
+}
+
+#define GRAPH_QUEUED 1
+#define GRAPH_UNINTERESTING 2
+#define GRAPH_DONE 4
+
+typedef struct {
+    corel_graph *graph;
+    u_int8_t *flags;
+    u_int32_t *heap;
+    u_int32_t len;
+    u_int32_t capacity;
+    u_int32_t interesting;
+} corel_graph_queue;
+
+/* Newest generation first, the commit date breaks ties */
+static bool corel_graph_queue_before(corel_graph_queue *queue, u_int32_t a, u_int32_t b) {
+    u_int32_t gen_a = corel_graph_generation(queue->graph, a);
+    u_int32_t gen_b = corel_graph_generation(queue->graph, b);
+    if (gen_a != gen_b) {
+        return gen_a > gen_b;
+    }
+    return corel_graph_date(queue->graph, a) > corel_graph_date(queue->graph, b);
+}
+
+static void corel_graph_queue_push(corel_graph_queue *queue, u_int32_t pos, bool uninteresting) {
+    u_int8_t *flags = &queue->flags[pos];
+    if (*flags & GRAPH_QUEUED) {
+        if (uninteresting && !(*flags & GRAPH_UNINTERESTING)) {
+            *flags |= GRAPH_UNINTERESTING;
+            queue->interesting--;
+        }
+        return;
+    }
+    *flags |= GRAPH_QUEUED | (uninteresting ? GRAPH_UNINTERESTING : 0);
+    queue->interesting += !uninteresting;
+
+    if (queue->len == queue->capacity) {
+        queue->capacity *= 2;
+        queue->heap = realloc(queue->heap, queue->capacity * sizeof(u_int32_t));
+    }
+    u_int32_t i = queue->len++;
+    while (i > 0 && corel_graph_queue_before(queue, pos, queue->heap[(i - 1) / 2])) {
+        queue->heap[i] = queue->heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    queue->heap[i] = pos;
+}
+
+static u_int32_t corel_graph_queue_pop(corel_graph_queue *queue) {
+    u_int32_t top = queue->heap[0];
+    u_int32_t last = queue->heap[--queue->len];
+    u_int32_t i = 0;
+    while (2 * i + 1 < queue->len) {
+        u_int32_t child = 2 * i + 1;
+        if (child + 1 < queue->len && corel_graph_queue_before(queue, queue->heap[child + 1], queue->heap[child])) {
+            child++;
+        }
+        if (!corel_graph_queue_before(queue, queue->heap[child], last)) {
+            break;
+        }
+        queue->heap[i] = queue->heap[child];
+        i = child;
+    }
+    queue->heap[i] = last;
+    return top;
+}
+
+int64_t corel_graph_walk(corel_graph *graph, const git_oid *head, git_commit *since, const git_oid *resume, bool first_parent, corel_commit_cb callback,
+                         void *payload) {
+    int64_t head_pos = corel_graph_find(graph, head);
+    int64_t since_pos = since ? corel_graph_find(graph, git_commit_id(since)) : -1;
+    int64_t resume_pos = resume ? corel_graph_find(graph, resume) : -1;
+    if (head_pos < 0 || (since && since_pos < 0) || (resume && resume_pos < 0)) {
+        return -1;
+    }
+
+    corel_graph_queue queue = {
+        .graph = graph,
+        .flags = calloc(graph->count, sizeof(u_int8_t)),
+        .capacity = 64,
+    };
+    queue.heap = malloc(queue.capacity * sizeof(u_int32_t));
+    corel_graph_queue_push(&queue, head_pos, false);
+    if (since_pos >= 0) {
+        corel_graph_queue_push(&queue, since_pos, true);
+    }
+    if (resume_pos >= 0) {
+        corel_graph_queue_push(&queue, resume_pos, true);
+    }
+
+    int64_t count = 0;
+    while (queue.interesting > 0) {
+        u_int32_t pos = corel_graph_queue_pop(&queue);
+        bool uninteresting = queue.flags[pos] & GRAPH_UNINTERESTING;
+        queue.flags[pos] |= GRAPH_DONE;
+        if (!uninteresting) {
+            queue.interesting--;
+            git_oid oid;
+            git_oid_fromraw(&oid, corel_graph_oid(graph, pos));
+            count++;
+            if (callback && callback(&oid, payload) != 0) {
+                break;
+            }
+        }
+        u_int32_t parent;
+        for (u_int32_t n = 0; corel_graph_parent(graph, pos, n, &parent) == 0; n++) {
+            if (!(queue.flags[parent] & GRAPH_DONE)) {
+                corel_graph_queue_push(&queue, parent, uninteresting);
+            }
+            // Whatever since can reach stays hidden, no matter which parent it is
+            if (first_parent && !uninteresting) {
+                break;
+            }
+        }
+    }
+
+    free(queue.heap);
+    free(queue.flags);
+    return count;
+}
@@ -0,0 +1,51 @@
+#ifndef COREL_GRAPH_H
+#define COREL_GRAPH_H
+
+#include "git2/commit.h"
+#include "git2/oid.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define GRAPH_CDAT_SIZE (GIT_OID_SHA1_SIZE + 16) // Root tree, parents, generation and commit date
+
+/* The commit-graph git keeps in objects/info. It has the parents, generation and commit date of every commit it knows,
+ * which is all a walk needs, so the commits themselves only get inflated for their subject */
+typedef struct {
+    const unsigned char *map;
+    size_t map_size;
+    u_int32_t count;
+    const unsigned char *fanout;
+    const unsigned char *oids;
+    const unsigned char *commits;
+    const unsigned char *edges;
+    u_int32_t edge_count;
+} corel_graph;
+
+/* Called for every commit of a walk. Reading the commit is up to the callback.
+ * Returning non-zero stops the walk. */
+typedef int (*corel_commit_cb)(const git_oid *oid, void *payload);
+
+/* Only single file graphs are read, split chains and graphs written without generation numbers are left to libgit2 */
+corel_graph *corel_graph_open(const char *objects_dir);
+void corel_graph_free(corel_graph *graph);
+const unsigned char *corel_graph_oid(corel_graph *graph, u_int32_t pos);
+/* Same as corel_pack_find, the graph shares the layout of the pack index */
+int64_t corel_graph_find(corel_graph *graph, const git_oid *oid);
+/* Puts the n-th parent of the commit at pos into out. Returns 1 once there are no more parents */
+int corel_graph_parent(corel_graph *graph, u_int32_t pos, u_int32_t n, u_int32_t *out);
+/* Topological level of a commit, higher than that of any of its parents */
+u_int32_t corel_graph_generation(corel_graph *graph, u_int32_t pos);
+/* Commit date in seconds since the epoch */
+u_int64_t corel_graph_date(corel_graph *graph, u_int32_t pos);
+
+/* Walks since..head, minus everything resume reaches, on top of the commit-graph. Commits come off newest generation
+ * first, so by the time a commit is popped all of its children have been seen and it is known whether since or resume
+ * can reach it. The walk ends once only uninteresting commits are left in the queue. With first_parent only the first
+ * parent of the commits in the range is followed, what since reaches stays hidden through every parent.
+ * Returns -1 without calling back if any of the starting points is missing from the graph. */
+int64_t corel_graph_walk(corel_graph *graph, const git_oid *head, git_commit *since, const git_oid *resume, bool first_parent, corel_commit_cb callback,
+                         void *payload);
+
+#endif
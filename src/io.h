@@ -0,0 +1,31 @@
+#ifndef COREL_IO_H
+#define COREL_IO_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+/* Every file format corel reads or writes keeps its numbers big endian */
+static inline u_int32_t corel_be32(const unsigned char *p) {
+    return ((u_int32_t)p[0] << 24) | ((u_int32_t)p[1] << 16) | ((u_int32_t)p[2] << 8) | (u_int32_t)p[3];
+}
+
+static inline u_int64_t corel_be64(const unsigned char *p) {
+    return ((u_int64_t)corel_be32(p) << 32) | corel_be32(p + 4);
+}
+
+static inline void corel_put_be32(unsigned char *p, u_int32_t value) {
+    p[0] = value >> 24;
+    p[1] = value >> 16;
+    p[2] = value >> 8;
+    p[3] = value;
+}
+
+static inline void corel_put_be64(unsigned char *p, u_int64_t value) {
+    corel_put_be32(p, value >> 32);
+    corel_put_be32(p + 4, value);
+}
+
+/* Maps the whole file read-only. NULL if it is missing or empty */
+const unsigned char *corel_mmap_file(const char *path, size_t *size);
+
+#endif
@@ -3,18 +3,37 @@
 #include "git2/remote.h"
 #include "git2/repository.h"
 #include "git2/revwalk.h"
+#include "git2/sys/commit_graph.h"
+#include "git2/sys/midx.h"
 #include "git2/tag.h"
+#include "git2/transaction.h"
+#include "bitmap.h"
+#include "bloom.h"
+#include "classify.h"
+#include "graph.h"
+#include "io.h"
+#include "oidmap.h"
+#include "pack.h"
+#include "semver.h"
 #include <argp.h>
 #include <bits/stdint-uintn.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fnmatch.h>
 #include <git2.h>
-#include <regex.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/param.h>
+#include <sys/stat.h>
 #include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+#include <zlib.h>
 
 // ERRORS
 typedef enum {
@@ -22,12 +41,15 @@ typedef enum {
     ERR_NO_REPOSITORY = 10,
     ERR_LATEST_TAG_NOT_FOUND = 30,
     ERR_TAG_NOT_CREATED = 40,
+    ERR_TAG_NOT_PUSHED = 45,
     ERR_NO_TAGS_NO_AUTO_INIT = 50,
     ERR_INVALID_INIT_TAG = 60,
     ERR_NO_COMMITS = 70,
+    ERR_RELEASE_PENDING = 80, // Not a failure, --check found at least one commit that needs a release
 } corel_error;
 
-static corel_error corel_last_error = 0;
+// Per thread, so every repository of --batch ends up with its own
+static __thread corel_error corel_last_error = 0;
 #define ERROR(err) corel_last_error = err;
 
 #define BOAST(...)                                                                                                                                             \
@@ -36,10 +58,16 @@ static corel_error corel_last_error = 0;
         printf("\n");                                                                                                                                          \
     }
 
+// With --batch stdout only carries the results, the lines of all threads are kept whole
 #define BOAST_ERR(...)                                                                                                                                         \
-    printf("ERROR: ");                                                                                                                                         \
-    printf(__VA_ARGS__);                                                                                                                                       \
-    printf("\n");
+    {                                                                                                                                                          \
+        FILE *boast_out = args.batch ? stderr : stdout;                                                                                                        \
+        flockfile(boast_out);                                                                                                                                  \
+        fprintf(boast_out, "ERROR: ");                                                                                                                         \
+        fprintf(boast_out, __VA_ARGS__);                                                                                                                       \
+        fprintf(boast_out, "\n");                                                                                                                              \
+        funlockfile(boast_out);                                                                                                                                \
+    }
 
 #ifdef DEBUG
 #define BOAST_DBG(...)                                                                                                                                         \
@@ -52,6 +80,7 @@ static corel_error corel_last_error = 0;
 #endif
 
 #define GIT_COMMIT_HEAD NULL
+#define TAG_REF_PREFIX "refs/tags/"
 
 #define ARG_DRY_RUN_SHORT 0x80
 #define ARG_PRINT_VERSION_SHORT 0x81
@@ -59,31 +88,61 @@ static corel_error corel_last_error = 0;
 #define ARG_INIT_VERSION_SHORT 0x83
 #define ARG_AUTO_INIT_VERSION_SHORT 0x84
 #define ARG_NO_PUSH_SHORT 0x85
-
-#define SEMVER_REGEX                                                                                                                                           \
-    "^v?(0|[1-9][[:digit:]]*)\\.(0|[1-9][[:digit:]]*)\\.(0|[1-9][[:digit:]]*)?(-[[:alnum:]-]+(\\.[[:alnum:]-]+)*)?(\\+[[:alnum:]-]+(\\.[[:alnum:]-]+)*)?$"
-
-/* Technically we don't need to keep this, but I will keep it here for documentation purposes */
-#define PATCH_REGEX "^(build|chore|ci|docs|env|fix|perf|revert|style|test)\\s?(\\(.+\\))?\\s?:\\s*(.+)"
-#define MINOR_REGEX "^(feat|refactor)\\s?(\\(.+\\))?\\s?:\\s*(.+)"
-#define MAJOR_REGEX "^(BREAKING CHANGE)\\s?(\\(.+\\))?\\s?:\\s*(.+)"
+#define ARG_CHECK_SHORT 0x86
+#define ARG_TAG_PATTERN_SHORT 0x87
+#define ARG_REACHABLE_TAGS_SHORT 0x88
+#define ARG_CLASSIFIER_SHORT 0x89
+#define ARG_CACHE_SHORT 0x8a
+#define ARG_INCREMENTAL_SHORT 0x8b
+#define ARG_WRITE_GRAPH_SHORT 0x8c
+#define ARG_FIRST_PARENT_SHORT 0x8d
+#define ARG_MERGE_BUMP_SHORT 0x8e
+#define ARG_PATH_FILTER_SHORT 0x8f
+#define ARG_CHANGED_PATHS_SHORT 0x90
+#define ARG_COMPONENTS_SHORT 0x91
+#define ARG_REMOTE_SHORT 0x92
+#define ARG_REMOTE_TAGS_SHORT 0x93
+#define ARG_RETRY_SHORT 0x94
+#define ARG_BATCH_SHORT 0x95
+#define ARG_JOBS_SHORT 0x96
+
+/* What a merge commit counts as with --first-parent */
+typedef enum {
+    MERGE_BUMP_MESSAGE,
+    MERGE_BUMP_BRANCH,
+} corel_merge_bump;
 
 typedef struct {
     bool quiet;
     bool print_version;
     bool dry_run;
     bool no_push;
+    char *remote;
+    bool remote_tags;
+    unsigned long retries;
+    char *batch;
+    unsigned long jobs;
     bool auto_init_tag;
+    bool check;
+    bool reachable_tags;
+    bool cache;
+    bool incremental;
+    bool write_graph;
+    unsigned long midx_packs;
+    bool first_parent;
+    corel_merge_bump merge_bump;
+    char **paths;
+    size_t path_count;
+    bool changed_paths;
+    char *components;
     char *init_version;
     char *repo_path;
+    char *tag_pattern;
+    size_t tag_prefix_len;
+    corel_classifier classifier;
 } cli_args;
 
 static cli_args args;
-static regex_t semver_regex = {0};
-static regex_t major_regex = {0};
-static regex_t minor_regex = {0};
-static regex_t patch_regex = {0};
-
 static struct argp_option options[] = {
     {"quiet", 'q', 0, 0, "Only show important output", 0},
     {"print-version", ARG_PRINT_VERSION_SHORT, 0, 0, "Only prints the current version of the git repository", 0},
@@ -91,7 +150,31 @@ static struct argp_option options[] = {
     {"repository-path", ARG_PATH_SHORT, "path", 0, "Path to the git repository", 0},
     {"auto-init-tag", ARG_AUTO_INIT_VERSION_SHORT, NULL, 0, "Creates the initial tag by analyzing all current commits starting from --initial-version", 0},
     {"initial-version", ARG_INIT_VERSION_SHORT, "version", 0, "The version to start from. Defaults to v0.1.0", 0},
-    {"no-push", ARG_NO_PUSH_SHORT, NULL, 0, "Tags will only be created locally and not pushed to the remote", 0},
+    {"no-push", ARG_NO_PUSH_SHORT, NULL, 0, "Tags will only be created locally. Without it new tags are pushed to --remote right away, earlier versions never pushed", 0},
+    {"remote", ARG_REMOTE_SHORT, "name", 0, "The remote new tags are pushed to. Defaults to origin", 0},
+    {"retry", ARG_RETRY_SHORT, "times", 0,
+     "When another release takes the tag first, move past it and try again up to this many times, waiting a little longer each time", 0},
+    {"remote-tags", ARG_REMOTE_TAGS_SHORT, NULL, 0, "Also consider the tags of the remote, listed without fetching anything, so no version is handed out twice", 0},
+    {"tag-pattern", ARG_TAG_PATTERN_SHORT, "glob", 0, "Only consider tags matching this glob, e.g. v* or component/v*. Defaults to *", 0},
+    {"reachable-tags", ARG_REACHABLE_TAGS_SHORT, NULL, 0, "Like git describe, only consider the nearest tags reachable from HEAD instead of the highest tag overall", 0},
+    {"classifier", ARG_CLASSIFIER_SHORT, "builtin|posix|pcre", 0, "How commits are classified. All of them follow the same rules, defaults to builtin", 0},
+    {"cache", ARG_CACHE_SHORT, NULL, 0, "Remember the classification of every commit in .git/corel so later runs can skip reading it", 0},
+    {"incremental", ARG_INCREMENTAL_SHORT, NULL, 0, "Remember where the last run stopped and only analyze the commits made since", 0},
+    {"write-graph", ARG_WRITE_GRAPH_SHORT, "packs", OPTION_ARG_OPTIONAL,
+     "After tagging, refresh the commit-graph and write a multi-pack-index once there are more than this many packs. Defaults to 8", 0},
+    {"first-parent", ARG_FIRST_PARENT_SHORT, NULL, 0, "Only follow the first parent of merges, each merge stands in for the branch it merged", 0},
+    {"merge-bump", ARG_MERGE_BUMP_SHORT, "message|branch", 0,
+     "With --first-parent, bump merges by their message and PR title or by the highest bump on the merged branch. Defaults to message", 0},
+    {"path", ARG_PATH_FILTER_SHORT, "path", 0, "Only count commits that change something below this path, e.g. services/billing. Can be given multiple times", 0},
+    {"changed-paths", ARG_CHANGED_PATHS_SHORT, NULL, 0, "Keep a Bloom filter of the changed paths of every commit in .git/corel, so --path can skip most commits without reading trees. "
+     "The first run that tags diffs all of history once, later ones only the new commits. --dry-run and --print-version never update it", 0},
+    {"components", ARG_COMPONENTS_SHORT, "file", 0,
+     "Version every component listed in the file in one go. Each line has a name, a path (. for everything) and a tag prefix like billing/v. "
+     "An untagged component released with --auto-init-tag makes the walk cover all of history", 0},
+    {"batch", ARG_BATCH_SHORT, "file", 0,
+     "Run over every repository listed in the file (- for stdin), one path per line, and print one JSON line per repository", 0},
+    {"jobs", ARG_JOBS_SHORT, "threads", 0, "How many repositories --batch works on at once. Defaults to the number of CPUs", 0},
+    {"check", ARG_CHECK_SHORT, NULL, 0, "Only checks whether a release is pending and exits with 80 if so. Stops at the first commit that causes a bump", 0},
     {0},
 };
 
@@ -119,102 +202,123 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state) {
     case ARG_NO_PUSH_SHORT:
         arguments->no_push = true;
         break;
-    case ARGP_KEY_ARG:
-        return 0;
-    default:
-        return ARGP_ERR_UNKNOWN;
+    case ARG_REMOTE_SHORT:
+        arguments->remote = arg;
+        break;
+    case ARG_REMOTE_TAGS_SHORT:
+        arguments->remote_tags = true;
+        break;
+    case ARG_BATCH_SHORT:
+        arguments->batch = arg;
+        break;
+    case ARG_JOBS_SHORT: {
+        char *end;
+        arguments->jobs = strtoul(arg, &end, 10);
+        if (*arg == '\0' || *end != '\0' || arguments->jobs == 0) {
+            argp_error(state, "Invalid thread count %s", arg);
+        }
+        break;
     }
-    return 0;
-}
-
-typedef struct {
-    uint64_t major;
-    uint64_t minor;
-    uint64_t patch;
-} corel_ver;
-
-typedef struct {
-    char *name;
-    corel_ver ver;
-} corel_taginfo;
-
-corel_taginfo *corel_taginfo_parse(char *tag_name) {
-#define MAX_MATCHES 4
-#define IDX_MAJOR 1
-#define IDX_MINOR 2
-#define IDX_PATCH 3
-
-    regmatch_t matches[MAX_MATCHES];
-    if (regexec(&semver_regex, tag_name, MAX_MATCHES, matches, 0) == REG_NOMATCH) {
-        return NULL;
+    case ARG_RETRY_SHORT: {
+        char *end;
+        arguments->retries = strtoul(arg, &end, 10);
+        if (*arg == '\0' || *end != '\0') {
+            argp_error(state, "Invalid retry count %s", arg);
+        }
+        break;
     }
-
-    corel_taginfo *tag_info = malloc(sizeof(corel_taginfo));
-    tag_info->name = tag_name;
-    tag_info->ver = (corel_ver){
-        .major = 0,
-        .minor = 0,
-        .patch = 0,
-    };
-
-    char str[strlen(tag_name)];
-
-    for (size_t i = 0; i < MAX_MATCHES; ++i) {
-        if (i == 0) {
-            continue;
+    case ARG_CHECK_SHORT:
+        arguments->check = true;
+        break;
+    case ARG_TAG_PATTERN_SHORT:
+        arguments->tag_pattern = arg;
+        break;
+    case ARG_REACHABLE_TAGS_SHORT:
+        arguments->reachable_tags = true;
+        break;
+    case ARG_CACHE_SHORT:
+        arguments->cache = true;
+        break;
+    case ARG_INCREMENTAL_SHORT:
+        arguments->incremental = true;
+        break;
+    case ARG_WRITE_GRAPH_SHORT:
+        arguments->write_graph = true;
+        if (arg) {
+            char *end;
+            arguments->midx_packs = strtoul(arg, &end, 10);
+            if (*arg == '\0' || *end != '\0') {
+                argp_error(state, "Invalid pack count %s", arg);
+            }
         }
-        regmatch_t match = matches[i];
-        size_t len = match.rm_eo - match.rm_so;
-        if (len == 0) {
-            continue;
+        break;
+    case ARG_FIRST_PARENT_SHORT:
+        arguments->first_parent = true;
+        break;
+    case ARG_MERGE_BUMP_SHORT:
+        if (strcmp(arg, "message") == 0) {
+            arguments->merge_bump = MERGE_BUMP_MESSAGE;
+        } else if (strcmp(arg, "branch") == 0) {
+            arguments->merge_bump = MERGE_BUMP_BRANCH;
+        } else {
+            argp_error(state, "Unknown merge bump %s", arg);
         }
-        for (size_t k = 0; k < len; k++) {
-            str[k] = tag_name[match.rm_so + k];
+        break;
+    case ARG_PATH_FILTER_SHORT:
+        // Trees are compared one path component at a time, slashes at either end would only get in the way
+        while (*arg == '/') {
+            arg++;
         }
-        str[len] = 0;
-
-        int version = atoi(str);
-        switch (i) {
-        case IDX_MAJOR:
-            tag_info->ver.major = version;
-            break;
-        case IDX_MINOR:
-            tag_info->ver.minor = version;
-            break;
-        case IDX_PATCH:
-            tag_info->ver.patch = version;
-            break;
-        default:
-            break;
+        for (size_t len = strlen(arg); len > 0 && arg[len - 1] == '/'; len--) {
+            arg[len - 1] = '\0';
         }
+        if (*arg == '\0') {
+            argp_error(state, "Empty path");
+        }
+        arguments->paths = realloc(arguments->paths, (arguments->path_count + 1) * sizeof(char *));
+        arguments->paths[arguments->path_count++] = arg;
+        break;
+    case ARG_CHANGED_PATHS_SHORT:
+        arguments->changed_paths = true;
+        break;
+    case ARG_COMPONENTS_SHORT:
+        arguments->components = arg;
+        break;
+    case ARG_CLASSIFIER_SHORT:
+        if (strcmp(arg, "builtin") == 0) {
+            arguments->classifier = CLASSIFIER_BUILTIN;
+        } else if (strcmp(arg, "posix") == 0) {
+            arguments->classifier = CLASSIFIER_POSIX;
+        } else if (strcmp(arg, "pcre") == 0) {
+            arguments->classifier = CLASSIFIER_PCRE;
+        } else {
+            argp_error(state, "Unknown classifier %s", arg);
+        }
+        break;
+    case ARGP_KEY_ARG:
+        return 0;
+    default:
+        return ARGP_ERR_UNKNOWN;
     }
-    return tag_info;
-}
-
-int corel_then_compare(int prev, int next) {
-    if (prev == 0) {
-        return next;
-    } else {
-        return prev;
-    }
-}
-
-int corel_taginfo_cmp(corel_taginfo *t1, corel_taginfo *t2) {
-#define CMP(target) t1->ver.target > t2->ver.target ? 1 : (t1->ver.target < t2->ver.target ? -1 : 0)
-    int res = CMP(major);
-    res = corel_then_compare(res, CMP(minor));
-    res = corel_then_compare(res, CMP(patch));
-    return res;
-}
-
-void corel_taginfo_free(corel_taginfo *tag_info) {
-    free(tag_info);
+    return 0;
 }
 
 void corel_taginfo_print(corel_taginfo *tag) {
     if (tag) {
         BOAST("Tag: %s (%lu %lu %lu)", tag->name, tag->ver.major, tag->ver.minor, tag->ver.patch)
+        BOAST_DBG("Pre-release: %.*s, Build: %.*s", (int)tag->prerelease_len, tag->prerelease ? tag->prerelease : "", (int)tag->build_len,
+                  tag->build ? tag->build : "")
+    }
+}
+
+/* The literal start of a tag pattern is what sits in front of the version in every tag name (component/v* -> component/v).
+ * It stops before any digits or dots, so v1.* still leaves the whole version to the parser. */
+size_t corel_tag_prefix_len(const char *pattern) {
+    size_t literal = strcspn(pattern, "*?[\\");
+    while (literal > 0 && ((pattern[literal - 1] >= '0' && pattern[literal - 1] <= '9') || pattern[literal - 1] == '.')) {
+        literal--;
     }
+    return literal;
 }
 
 int corel_cli_parse_args(int argc, char *argv[], cli_args *args) {
@@ -226,10 +330,38 @@ int corel_cli_parse_args(int argc, char *argv[], cli_args *args) {
     args->repo_path = ".";
     args->auto_init_tag = false;
     args->no_push = false;
+    args->remote = NULL;
+    args->remote_tags = false;
+    args->retries = 0;
+    args->batch = NULL;
+    args->jobs = 0;
+    args->check = false;
+    args->reachable_tags = false;
+    args->classifier = CLASSIFIER_BUILTIN;
+    args->cache = false;
+    args->incremental = false;
+    args->write_graph = false;
+    args->midx_packs = 8;
+    args->first_parent = false;
+    args->merge_bump = MERGE_BUMP_MESSAGE;
+    args->paths = NULL;
+    args->path_count = 0;
+    args->changed_paths = false;
+    args->components = NULL;
     args->init_version = "v0.1.0";
+    args->tag_pattern = "*";
 
     error_t err = argp_parse(&argp, argc, argv, 0, 0, args);
+    if (args->batch) {
+        // Components print a line each, that does not go together with one line per repository
+        if (args->components) {
+            fprintf(stderr, "Error: --batch does not support --components.\n");
+            return 1;
+        }
+        args->quiet = true;
+    }
 
+    args->tag_prefix_len = corel_tag_prefix_len(args->tag_pattern);
     return err;
 }
 
@@ -241,8 +373,8 @@ int corel_cli_parse_args(int argc, char *argv[], cli_args *args) {
     } array_name;                                                                                                                                              \
                                                                                                                                                                \
     void array_name##_init(array_name **out, u_int64_t capacity) {                                                                                             \
-        array_name *new = malloc(sizeof(corel_commit_array));                                                                                                  \
-        new->entries = calloc(capacity, sizeof(git_commit *));                                                                                                 \
+        array_name *new = malloc(sizeof(array_name));                                                                                                          \
+        new->entries = calloc(capacity, sizeof(target_struct *));                                                                                              \
         new->len = 0;                                                                                                                                          \
         new->capacity = capacity;                                                                                                                              \
         *out = new;                                                                                                                                            \
@@ -272,76 +404,338 @@ int corel_cli_parse_args(int argc, char *argv[], cli_args *args) {
         return 0;                                                                                                                                              \
     }
 
-DYNAMIC_ARRAY(corel_commit_array, git_commit);
 DYNAMIC_ARRAY(corel_tag_array, git_tag);
+DYNAMIC_ARRAY(corel_taginfo_array, corel_taginfo);
+
+/* The classification only ever looks at the start of a message. Keep the subject and the line after it, that way a
+ * colon followed by an empty subject still sees the body like it would on the full message. A scope that closes after
+ * the second line or past COREL_SUBJECT_MAX is not seen, those commits count as PATCH (tests/subject_test.sh) */
+#define COREL_SUBJECT_MAX 1024
+#define COREL_SUBJECT_LINES 2
+#define COREL_INFLATE_CHUNK 512
+
+DYNAMIC_ARRAY(corel_pack_array, corel_pack);
+
+/* Reads commit subjects straight from the loose objects and packs, inflating only as much as the subject needs. Anything
+ * it cannot handle on its own (deltas, alternates, ...) goes through the regular odb. */
+typedef struct {
+    git_odb *odb;
+    char *objects_dir;
+    corel_pack_array *packs;
+    corel_graph *graph;
+} corel_reader;
+
+void corel_reader_free(corel_reader *reader) {
+    if (!reader) {
+        return;
+    }
+    if (reader->packs) {
+        corel_pack_array_free(reader->packs);
+    }
+    corel_graph_free(reader->graph);
+    git_odb_free(reader->odb);
+    free(reader->objects_dir);
+    free(reader);
+}
+
+int corel_reader_open(corel_reader **out, git_repository *repository) {
+    corel_reader *reader = calloc(1, sizeof(corel_reader));
+    git_buf objects_dir = {0};
+    if (git_repository_odb(&reader->odb, repository) != 0 ||
+        git_repository_item_path(&objects_dir, repository, GIT_REPOSITORY_ITEM_OBJECTS) != 0) {
+        corel_reader_free(reader);
+        return 1;
+    }
+    reader->objects_dir = strdup(objects_dir.ptr);
+    git_buf_dispose(&objects_dir);
+    reader->graph = corel_graph_open(reader->objects_dir);
+
+    corel_pack_array_init(&reader->packs, 4);
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%spack", reader->objects_dir);
+    DIR *dir = opendir(path);
+    if (!dir) {
+        *out = reader;
+        return 0;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        size_t len = strlen(entry->d_name);
+        if (len < strlen(".idx") || strcmp(entry->d_name + len - strlen(".idx"), ".idx") != 0) {
+            continue;
+        }
+        snprintf(path, sizeof(path), "%spack/%s", reader->objects_dir, entry->d_name);
+        corel_pack *pack = corel_pack_open(path);
+        if (pack) {
+            corel_pack_array_push(reader->packs, pack);
+        }
+    }
+    closedir(dir);
+    *out = reader;
+    return 0;
+}
+
+typedef enum {
+    SUBJECT_OBJECT_HEADER,
+    SUBJECT_COMMIT_HEADERS,
+    SUBJECT_MESSAGE,
+    SUBJECT_DONE,
+} corel_subject_stage;
+
+typedef struct {
+    corel_subject_stage stage;
+    char prev;
+    u_int8_t lines;
+    char *out;
+    size_t len;
+    size_t size;
+} corel_subject_parser;
+
+/* Eats inflated commit bytes until the message start has been copied. Loose objects start with "commit <size>\0", packed
+ * ones right at the headers. The headers end at the first empty line. */
+static void corel_subject_feed(corel_subject_parser *parser, const char *data, size_t len) {
+    for (size_t i = 0; i < len && parser->stage != SUBJECT_DONE; i++) {
+        char c = data[i];
+        switch (parser->stage) {
+        case SUBJECT_OBJECT_HEADER:
+            if (c == '\0') {
+                parser->stage = SUBJECT_COMMIT_HEADERS;
+            }
+            break;
+        case SUBJECT_COMMIT_HEADERS:
+            if (c == '\n' && parser->prev == '\n') {
+                parser->stage = SUBJECT_MESSAGE;
+            }
+            parser->prev = c;
+            break;
+        case SUBJECT_MESSAGE:
+            parser->out[parser->len++] = c;
+            if (c == '\n') {
+                parser->lines++;
+            }
+            if (parser->lines == COREL_SUBJECT_LINES || parser->len + 1 >= parser->size) {
+                parser->stage = SUBJECT_DONE;
+            }
+            break;
+        case SUBJECT_DONE:
+            break;
+        }
+    }
+}
+
+static int corel_subject_inflate(corel_subject_parser *parser, const unsigned char *data, size_t len) {
+    z_stream stream = {0};
+    if (inflateInit(&stream) != Z_OK) {
+        return 1;
+    }
+    stream.next_in = (Bytef *)data;
+    stream.avail_in = len > UINT32_MAX ? UINT32_MAX : len;
+
+    unsigned char chunk[COREL_INFLATE_CHUNK];
+    int err = Z_OK;
+    while (parser->stage != SUBJECT_DONE && err == Z_OK) {
+        stream.next_out = chunk;
+        stream.avail_out = sizeof(chunk);
+        err = inflate(&stream, Z_SYNC_FLUSH);
+        if (err == Z_OK || err == Z_STREAM_END) {
+            corel_subject_feed(parser, (char *)chunk, sizeof(chunk) - stream.avail_out);
+        }
+    }
+    inflateEnd(&stream);
+    return parser->stage == SUBJECT_DONE || err == Z_STREAM_END ? 0 : 1;
+}
+
+static int corel_reader_subject_loose(corel_subject_parser *parser, corel_reader *reader, const git_oid *oid) {
+    char hex[GIT_OID_SHA1_HEXSIZE + 1];
+    char path[PATH_MAX];
+    git_oid_tostr(hex, sizeof(hex), oid);
+    snprintf(path, sizeof(path), "%s%.2s/%s", reader->objects_dir, hex, hex + 2);
+
+    size_t size = 0;
+    const unsigned char *data = corel_mmap_file(path, &size);
+    if (!data) {
+        return 1;
+    }
+    parser->stage = SUBJECT_OBJECT_HEADER;
+    int err = corel_subject_inflate(parser, data, size);
+    munmap((void *)data, size);
+    return err;
+}
+
+static int corel_reader_subject_packed(corel_subject_parser *parser, corel_reader *reader, const git_oid *oid) {
+    for (size_t i = 0; i < reader->packs->len; i++) {
+        corel_pack *pack = reader->packs->entries[i];
+        int64_t pos = corel_pack_find(pack, oid);
+        if (pos < 0) {
+            continue;
+        }
+        if (!pack->pack && !(pack->pack = corel_mmap_file(pack->pack_path, &pack->pack_size))) {
+            return 1;
+        }
+
+        u_int64_t offset = corel_pack_offset(pack, pos);
+        if (offset >= pack->pack_size) {
+            return 1;
+        }
+        // Deltified commits need their base, leave those to libgit2
+        const unsigned char *header = pack->pack + offset;
+        if (((header[0] >> 4) & 7) != PACK_OBJ_COMMIT) {
+            return 1;
+        }
+        // The size is a varint, a pack cut short in the middle of it goes to the odb as well
+        const unsigned char *end = pack->pack + pack->pack_size;
+        while (header < end && (*header & 0x80)) {
+            header++;
+        }
+        if (++header >= end) {
+            return 1;
+        }
+
+        parser->stage = SUBJECT_COMMIT_HEADERS;
+        return corel_subject_inflate(parser, header, pack->pack + pack->pack_size - header);
+    }
+    return 1;
+}
+
+static int corel_reader_subject_odb(corel_subject_parser *parser, corel_reader *reader, const git_oid *oid) {
+    git_odb_object *object;
+    if (git_odb_read(&object, reader->odb, oid) != 0) {
+        return 1;
+    }
+    parser->stage = SUBJECT_COMMIT_HEADERS;
+    corel_subject_feed(parser, git_odb_object_data(object), git_odb_object_size(object));
+    git_odb_object_free(object);
+    return 0;
+}
+
+/* Copies the start of the commit message into out (see COREL_SUBJECT_MAX), without ever parsing the whole commit */
+int corel_reader_subject(char *out, size_t size, corel_reader *reader, const git_oid *oid) {
+    corel_subject_parser parser = {.out = out, .size = size};
+
+#define TRY_SUBJECT(reader_fn)                                                                                                                                 \
+    parser.len = 0;                                                                                                                                            \
+    parser.lines = 0;                                                                                                                                          \
+    parser.prev = 0;                                                                                                                                           \
+    if (reader_fn(&parser, reader, oid) == 0) {                                                                                                                \
+        out[parser.len] = '\0';                                                                                                                                \
+        return 0;                                                                                                                                              \
+    }
+
+    TRY_SUBJECT(corel_reader_subject_packed)
+    TRY_SUBJECT(corel_reader_subject_loose)
+    TRY_SUBJECT(corel_reader_subject_odb)
+    return 1;
+}
 
-void corel_commit_array_collect(corel_commit_array **out, git_repository *repository, git_commit *since, u_int64_t max) {
-    corel_commit_array_init(out, 1);
+/* Oldest commit first, needed whenever the order of the bumps matters */
+#define COREL_SORT_CHRONOLOGICAL (GIT_SORT_TOPOLOGICAL | GIT_SORT_TIME | GIT_SORT_REVERSE)
 
+/* Walks since..HEAD, minus everything reachable from resume if one is given. Any sorting besides GIT_SORT_NONE makes
+ * libgit2 buffer the whole range before yielding the first commit, so only ask for it when the callback depends on the
+ * order. */
+u_int64_t corel_commit_walk(git_repository *repository, git_commit *since, const git_oid *resume, unsigned int sorting, corel_commit_cb callback,
+                            void *payload) {
     git_revwalk *walk;
     git_revwalk_new(&walk, repository);
-    git_revwalk_sorting(walk, GIT_SORT_TOPOLOGICAL | GIT_SORT_TIME | GIT_SORT_REVERSE);
+    git_revwalk_sorting(walk, sorting);
+    if (args.first_parent) {
+        git_revwalk_simplify_first_parent(walk);
+    }
 
+    git_revwalk_push_head(walk);
     if (since) {
-        // git_revwalk_push(walk, git_commit_id(since));
-        git_revwalk_push_head(walk);
         git_revwalk_hide(walk, git_commit_id(since));
-    } else {
-        git_revwalk_push_head(walk);
+    }
+    if (resume) {
+        git_revwalk_hide(walk, resume);
     }
 
-    git_commit *curr_commit = NULL;
+    u_int64_t count = 0;
     git_oid oid;
     while (git_revwalk_next(&oid, walk) == 0) {
-        if (git_commit_lookup(&curr_commit, repository, &oid) == 0) {
-            corel_commit_array_push(*out, curr_commit);
-        }
-
-        if (max > 0 && (*out)->len > max) {
+        count++;
+        if (callback && callback(&oid, payload) != 0) {
             break;
         }
     }
 
-    u_int64_t count = (*out)->len;
-    if (count > 0) {
-        BOAST("Woaah, you have %lu commit(s)", count);
-    }
-
     git_revwalk_free(walk);
+    return count;
 }
 
-typedef enum {
-    MAJOR,
-    MINOR,
-    PATCH,
-    NONE,
-} COREL_RELEASE_BUMP;
+/* Whether the header of packed-refs promises a "^" line after every annotated tag ("fully-peeled"). Older files only
+ * peeled some of them, or none at all */
+static bool corel_packed_refs_fully_peeled(git_repository *repository) {
+    char path[PATH_MAX];
+    char header[256] = {0};
+    snprintf(path, sizeof(path), "%spacked-refs", git_repository_commondir(repository));
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return false;
+    }
+    bool fully_peeled = fgets(header, sizeof(header), file) && strncmp(header, "# pack-refs with:", 17) == 0 && strstr(header, " fully-peeled");
+    fclose(file);
+    return fully_peeled;
+}
+
+/* Makes sure the target is the commit and not an annotated tag object. A fully-peeled packed-refs stores the peeled value
+ * of annotated tags next to them, so a packed ref without one is no tag object. Loose refs and older packed-refs need an
+ * object read. fully_peeled remembers the packed-refs header between calls, start it at -1 */
+int corel_taginfo_peel(corel_taginfo *tag, git_repository *repository, int *fully_peeled) {
+    if (tag->peeled) {
+        return 0;
+    }
 
-COREL_RELEASE_BUMP corel_analyze_commit_message(char *commit_message) {
-    if (regexec(&major_regex, commit_message, 0, NULL, 0) == 0) {
-        return MAJOR;
+    char path[PATH_MAX];
+    struct stat st;
+    snprintf(path, sizeof(path), "%s%s%s", git_repository_commondir(repository), TAG_REF_PREFIX, tag->name);
+    bool loose = stat(path, &st) == 0;
+    if (!loose && *fully_peeled < 0) {
+        *fully_peeled = corel_packed_refs_fully_peeled(repository);
     }
-    if (regexec(&minor_regex, commit_message, 0, NULL, 0) == 0) {
-        return MINOR;
+    if (loose || !*fully_peeled) {
+        git_odb *odb;
+        size_t size;
+        git_object_t type;
+        if (git_repository_odb(&odb, repository) != 0) {
+            return 1;
+        }
+        int err = git_odb_read_header(&size, &type, odb, &tag->target);
+        git_odb_free(odb);
+        if (err != 0) {
+            return 1;
+        }
+
+        if (type == GIT_OBJECT_TAG) {
+            git_object *obj;
+            git_object *commit;
+            if (git_object_lookup(&obj, repository, &tag->target, GIT_OBJECT_TAG) != 0) {
+                return 1;
+            }
+            err = git_object_peel(&commit, obj, GIT_OBJECT_COMMIT);
+            git_object_free(obj);
+            if (err != 0) {
+                return 1;
+            }
+            git_oid_cpy(&tag->target, git_object_id(commit));
+            git_object_free(commit);
+        }
     }
-    return PATCH;
+    tag->peeled = true;
+    return 0;
 }
 
 int corel_taginfo_commit(git_commit **out, corel_taginfo *tag, git_repository *repository) {
     git_object *obj;
+    int fully_peeled = -1;
 
-    if (git_revparse_single(&obj, repository, tag->name) != 0) {
+    if (corel_taginfo_peel(tag, repository, &fully_peeled) != 0 || git_object_lookup(&obj, repository, &tag->target, GIT_OBJECT_ANY) != 0) {
         return 1;
     }
 
-    switch (git_object_type(obj)) {
-    case GIT_OBJECT_COMMIT:
-        *out = (git_commit *)obj;
-        return 0;
-    default:
-        git_object_free(obj);
-        return 1;
-    }
+    int err = git_object_peel((git_object **)out, obj, GIT_OBJECT_COMMIT);
+    git_object_free(obj);
+    return err != 0;
 }
 
 char *corel_ver_tostr(corel_ver *version) {
@@ -351,6 +745,20 @@ char *corel_ver_tostr(corel_ver *version) {
     return out;
 }
 
+char *corel_tag_name_prefixed(const char *prefix, size_t prefix_len, corel_ver *version) {
+    bool has_v = prefix_len > 0 && (prefix[prefix_len - 1] == 'v' || prefix[prefix_len - 1] == 'V');
+
+    char *out = malloc(prefix_len + VERSION_STR_MAX_ALLOC);
+    memcpy(out, prefix, prefix_len);
+    sprintf(out + prefix_len, "%s%lu.%lu.%lu", has_v ? "" : "v", version->major, version->minor, version->patch);
+    return out;
+}
+
+/* The tag name for a version, carrying the prefix of --tag-pattern so the next run picks it up again */
+char *corel_tag_name(corel_ver *version) {
+    return corel_tag_name_prefixed(args.tag_pattern, args.tag_prefix_len, version);
+}
+
 void corel_ver_bump(corel_ver *version, COREL_RELEASE_BUMP type) {
     switch (type) {
     case MAJOR:
@@ -372,208 +780,2105 @@ void corel_ver_bump(corel_ver *version, COREL_RELEASE_BUMP type) {
     }
 }
 
-void corel_bump_version(corel_ver *version, corel_commit_array *commits, bool count_individually) {
-    char *version_old = corel_ver_tostr(version);
+#define COREL_DIR "corel/"
+#define CACHE_FILE COREL_DIR "classification-cache"
+#define CHECKPOINT_FILE COREL_DIR "checkpoint"
+#define BLOOM_FILE COREL_DIR "changed-paths"
+#define CACHE_MAGIC "CRLC"
+#define CACHE_VERSION 1
+#define CACHE_HEADER_SIZE 20 // magic, version, rules hash, entry count
+#define CACHE_ENTRY_SIZE (GIT_OID_SHA1_SIZE + 1)
 
-    COREL_RELEASE_BUMP highest = NONE;
-    for (size_t i = 0; i < commits->len; i++) {
-        COREL_RELEASE_BUMP current = corel_analyze_commit_message(git_commit_message(commits->entries[i]));
-        if (count_individually) {
-            corel_ver_bump(version, current);
-        } else if (current < highest) {
-            highest = current;
-        }
-    }
+/* Everything a classification depends on. Changing any of it changes the hash and throws the cache away */
+#define CACHE_RULES MAJOR_REGEX "\n" MINOR_REGEX "\n" PATCH_REGEX
 
-    if (!count_individually) {
-        corel_ver_bump(version, highest);
+/* Commit OID -> COREL_RELEASE_BUMP. On disk the entries are sorted by OID and looked up by binary search right in the
+ * mapping, new classifications are collected in memory and merged in by corel_cache_close */
+typedef struct {
+    char *path;
+    u_int64_t rules_hash;
+    const unsigned char *map;
+    size_t map_size;
+    const unsigned char *entries;
+    u_int32_t count;
+    unsigned char *added;
+    size_t added_len;
+    size_t added_capacity;
+} corel_cache;
+
+static u_int64_t corel_fnv1a(const char *data, u_int64_t hash) {
+    for (; *data; data++) {
+        hash = (hash ^ (unsigned char)*data) * 0x100000001b3ULL;
     }
-
-    char *version_new = corel_ver_tostr(version);
-    BOAST_DBG("Bumped Version from %s->%s in %lu commits", version_old, version_new, commits->len);
-    free(version_old);
-    free(version_new);
+    return hash;
 }
 
-void corel_tag_now(char *tag_name, char *rev, git_repository *repository) {
-#define GIT_REMOTE_CALLBACKS_VERSION 1
-#define GIT_REMOTE_OPTIONS_VERSION 1
-    git_object *target;
-    git_oid created;
-    git_revparse_single(&target, repository, rev);
-    if (git_tag_create_lightweight(&created, repository, tag_name, target, false) == 0) {
-        // if (!args.no_push) {
-        //     git_remote *remote;
-        //     if (git_remote_lookup(&remote, repository, "origin") != 0) {
-        //         BOAST_ERR("Failed to lookup origin remote");
-        //         goto cleanup;
-        //     }
-        //
-        //     char *refspec = "refs/heads/master";
-        //     const git_strarray refspecs = {&refspec, 1};
-        //     git_push_options options;
-        //     git_remote_callbacks callbacks;
-        //
-        //     git_remote_init_callbacks(&callbacks, GIT_REMOTE_CALLBACKS_VERSION);
-        //     callbacks.credentials = cred_acquire_cb;
-        //
-        //     git_push_options_init(&options, GIT_REMOTE_OPTIONS_VERSION);
-        //     options.callbacks = callbacks;
-        //
-        //     git_remote_push(remote, &refspecs, &options);
-        //     BOAST("Pushed tag to origin");
-        // }
-    } else {
-        ERROR(ERR_TAG_NOT_CREATED)
-        BOAST_ERR("Failed to create tag %s", tag_name);
-    }
-    git_object_free(target);
+static u_int64_t corel_rules_hash(void) {
+    char subject_window[32];
+    snprintf(subject_window, sizeof(subject_window), "%d/%d", COREL_SUBJECT_MAX, COREL_SUBJECT_LINES);
+    return corel_fnv1a(subject_window, corel_fnv1a(CACHE_RULES, 0xcbf29ce484222325ULL));
 }
 
-void corel_try_auto_init(git_repository *repository) {
-    if (!args.auto_init_tag) {
-        ERROR(ERR_NO_TAGS_NO_AUTO_INIT)
-        BOAST("No tags have been created yet and --auto-init-tag was not provided.");
-        return;
+/* The checkpoint also depends on which commits count and what merges count as */
+static u_int64_t corel_checkpoint_hash(void) {
+    char scope[32];
+    snprintf(scope, sizeof(scope), "%d/%d", args.first_parent, args.merge_bump);
+    u_int64_t hash = corel_fnv1a(scope, corel_rules_hash());
+    for (size_t i = 0; i < args.path_count; i++) {
+        hash = corel_fnv1a(args.paths[i], corel_fnv1a("\n", hash));
     }
+    return hash;
+}
 
-    BOAST("No tags have been created yet. Figuring out initial version, starting from %s", args.init_version);
-    corel_taginfo *version = corel_taginfo_parse(args.init_version);
-    if (!version) {
-        ERROR(ERR_INVALID_INIT_TAG)
-        BOAST_ERR("Could not parse initial version %s", args.init_version);
-        return;
-    }
+/* Files corel keeps for itself live next to the refs, so all worktrees share them */
+static char *corel_state_path(git_repository *repository, const char *file) {
+    const char *commondir = git_repository_commondir(repository);
+    char *path = malloc(strlen(commondir) + strlen(file) + 1);
+    sprintf(path, "%s%s", commondir, file);
+    return path;
+}
 
-    corel_commit_array *commits = {0};
-    corel_commit_array_collect(&commits, repository, GIT_COMMIT_HEAD, -1);
-    corel_bump_version(&version->ver, commits, true);
+static void corel_state_mkdir(const char *path) {
+    char dir[strlen(path) + 1];
+    strcpy(dir, path);
+    *strrchr(dir, '/') = '\0';
+    mkdir(dir, 0755);
+}
 
-    if (!args.dry_run) {
-        char *version_name = corel_ver_tostr(&version->ver);
-        corel_tag_now(version_name, "HEAD", repository);
-        free(version_name);
+/* Writing any of these files takes well under a second, a lock older than this was left behind by a run that died */
+#define STATE_LOCK_STALE_SECONDS 60
+
+/* Creates the lock file the new contents go into before they get renamed over the old ones. Only one run can hold it,
+ * but a stale lock does not keep every later run from writing */
+static FILE *corel_state_lock(const char *lock_path, const char *mode) {
+    FILE *out = fopen(lock_path, mode);
+    struct stat st;
+    if (!out && errno == EEXIST && stat(lock_path, &st) == 0 && time(NULL) - st.st_mtime > STATE_LOCK_STALE_SECONDS) {
+        BOAST_DBG("Removing the stale lock %s", lock_path);
+        unlink(lock_path);
+        out = fopen(lock_path, mode);
     }
-
-    corel_commit_array_free(commits);
-    corel_taginfo_free(version);
+    return out;
 }
 
-#define COMPILE_REGEX(target, regex)                                                                                                                           \
-    if (regcomp(&target, regex, REG_EXTENDED | REG_ICASE) != 0) {                                                                                              \
-        fprintf(stderr, "Error: could not compile %s regex.\n", #target);                                                                                      \
-        return 1;                                                                                                                                              \
-    };
-
-int main(int argc, char *argv[]) {
-    COMPILE_REGEX(semver_regex, SEMVER_REGEX);
-    COMPILE_REGEX(major_regex, MAJOR_REGEX);
-    COMPILE_REGEX(minor_regex, MINOR_REGEX);
-    COMPILE_REGEX(patch_regex, PATCH_REGEX);
+corel_cache *corel_cache_open(git_repository *repository) {
+    corel_cache *cache = calloc(1, sizeof(corel_cache));
+    cache->rules_hash = corel_rules_hash();
+    cache->path = corel_state_path(repository, CACHE_FILE);
 
-    if (corel_cli_parse_args(argc, argv, &args) != 0) {
-        printf("Could not parse args\n");
-        return ERR_PARSE_ARGS;
+    cache->map = corel_mmap_file(cache->path, &cache->map_size);
+    if (!cache->map) {
+        return cache;
     }
-
-    git_libgit2_init();
-    BOAST("Corel v0.0.1"); // TODO: Replace with actual version
-
-    git_repository *repository = NULL;
-    corel_commit_array *commits = NULL;
-    corel_taginfo *latest_tag = NULL;
-    git_repository_open(&repository, args.repo_path);
-
-    if (!repository) {
-        ERROR(ERR_NO_REPOSITORY)
-        BOAST_ERR("Provided path is not a git repository");
-        return ERR_NO_REPOSITORY;
+    u_int32_t count = cache->map_size >= CACHE_HEADER_SIZE ? corel_be32(cache->map + 16) : 0;
+    if (cache->map_size < CACHE_HEADER_SIZE || memcmp(cache->map, CACHE_MAGIC, 4) != 0 || corel_be32(cache->map + 4) != CACHE_VERSION ||
+        corel_be64(cache->map + 8) != cache->rules_hash || cache->map_size != CACHE_HEADER_SIZE + (size_t)count * CACHE_ENTRY_SIZE) {
+        BOAST_DBG("Classification cache is stale, starting over");
+        return cache;
     }
+    cache->entries = cache->map + CACHE_HEADER_SIZE;
+    cache->count = count;
+    return cache;
+}
 
-    // Fast Lookup to see if we have any commits
-    corel_commit_array_collect(&commits, repository, GIT_COMMIT_HEAD, 1);
-    if (commits->len == 0) {
-        ERROR(ERR_NO_COMMITS)
-        BOAST_ERR("You have not made any commits yet. Why even run this?")
-        goto cleanup;
+/* Returns 0 and sets bump on a hit. A NULL cache never hits */
+int corel_cache_get(corel_cache *cache, const git_oid *oid, COREL_RELEASE_BUMP *bump) {
+    if (!cache) {
+        return 1;
     }
-    corel_commit_array_free(commits);
-    commits = NULL;
-
-    BOAST("Grabbing tags...");
-    git_strarray tag_names = {0};
-    git_tag_list(&tag_names, repository);
-
-    BOAST("Tags: %lu", tag_names.count);
-    for (size_t i = 0; i < tag_names.count; i++) {
-        corel_taginfo *tag = corel_taginfo_parse(tag_names.strings[i]);
-
-        if (tag == NULL) {
-            continue;
+    u_int32_t lo = 0;
+    u_int32_t hi = cache->count;
+    while (lo < hi) {
+        u_int32_t mid = lo + (hi - lo) / 2;
+        const unsigned char *entry = cache->entries + (size_t)mid * CACHE_ENTRY_SIZE;
+        int cmp = memcmp(entry, oid->id, GIT_OID_SHA1_SIZE);
+        if (cmp == 0) {
+            *bump = entry[GIT_OID_SHA1_SIZE];
+            return 0;
         }
-
-        if (latest_tag == NULL || (corel_taginfo_cmp(tag, latest_tag)) > 0) {
-            corel_taginfo_free(latest_tag);
-            latest_tag = tag;
+        if (cmp < 0) {
+            lo = mid + 1;
         } else {
-            corel_taginfo_free(tag);
+            hi = mid;
         }
     }
+    return 1;
+}
 
-    if (latest_tag == NULL) {
-        corel_try_auto_init(repository);
-        git_strarray_free(&tag_names);
-        goto cleanup;
+void corel_cache_put(corel_cache *cache, const git_oid *oid, COREL_RELEASE_BUMP bump) {
+    if (!cache) {
+        return;
     }
+    if (cache->added_len == cache->added_capacity) {
+        cache->added_capacity = cache->added_capacity ? cache->added_capacity * 2 : 256;
+        cache->added = realloc(cache->added, cache->added_capacity * CACHE_ENTRY_SIZE);
+    }
+    unsigned char *entry = cache->added + cache->added_len++ * CACHE_ENTRY_SIZE;
+    memcpy(entry, oid->id, GIT_OID_SHA1_SIZE);
+    entry[GIT_OID_SHA1_SIZE] = bump;
+}
 
-    BOAST("Found Latest Tag: ");
-    corel_taginfo_print(latest_tag);
+static int corel_cache_entry_cmp(const void *e1, const void *e2) {
+    return memcmp(e1, e2, GIT_OID_SHA1_SIZE);
+}
 
-    git_commit *latest_tag_commit;
-    if (corel_taginfo_commit(&latest_tag_commit, latest_tag, repository) != 0) {
-        ERROR(ERR_LATEST_TAG_NOT_FOUND);
-        BOAST_ERR("Failed to lookup commit for the latest tag. This should not happen!");
-        git_strarray_free(&tag_names);
-        goto cleanup;
+/* Merges the new entries into the sorted ones and swaps the file in atomically */
+static int corel_cache_write(corel_cache *cache) {
+    qsort(cache->added, cache->added_len, CACHE_ENTRY_SIZE, corel_cache_entry_cmp);
+    corel_state_mkdir(cache->path);
+
+    char tmp_path[strlen(cache->path) + sizeof(".lock")];
+    sprintf(tmp_path, "%s.lock", cache->path);
+    FILE *out = corel_state_lock(tmp_path, "wbx");
+    if (!out) {
+        return 1;
     }
 
-    BOAST_DBG("Latest Tag Refers to commit %s", git_commit_message(latest_tag_commit));
+    unsigned char header[CACHE_HEADER_SIZE];
+    memcpy(header, CACHE_MAGIC, 4);
+    corel_put_be32(header + 4, CACHE_VERSION);
+    corel_put_be64(header + 8, cache->rules_hash);
+    corel_put_be32(header + 16, 0);
+    fwrite(header, 1, sizeof(header), out);
+
+    u_int32_t written = 0;
+    size_t old = 0;
+    size_t new = 0;
+    while (old < cache->count || new < cache->added_len) {
+        const unsigned char *old_entry = cache->entries + old * CACHE_ENTRY_SIZE;
+        const unsigned char *new_entry = cache->added + new * CACHE_ENTRY_SIZE;
+        int cmp = old == cache->count ? 1 : (new == cache->added_len ? -1 : corel_cache_entry_cmp(old_entry, new_entry));
+        if (cmp <= 0) {
+            fwrite(old_entry, 1, CACHE_ENTRY_SIZE, out);
+            old++;
+            new += cmp == 0;
+        } else {
+            fwrite(new_entry, 1, CACHE_ENTRY_SIZE, out);
+            new++;
+        }
+        written++;
+    }
 
-    corel_commit_array_collect(&commits, repository, latest_tag_commit, -1);
-    corel_bump_version(&latest_tag->ver, commits, false);
-    char *version_name = corel_ver_tostr(&latest_tag->ver);
+    corel_put_be32(header + 16, written);
+    fseek(out, 16, SEEK_SET);
+    fwrite(header + 16, 1, 4, out);
+    if (fclose(out) != 0 || rename(tmp_path, cache->path) != 0) {
+        unlink(tmp_path);
+        return 1;
+    }
+    return 0;
+}
 
-    if (args.print_version) {
-        printf("%s\n", version_name);
-        goto cleanup_post_tag;
+void corel_cache_close(corel_cache *cache, bool persist) {
+    if (!cache) {
+        return;
     }
-    if (commits->len == 0) {
-        BOAST("No new commits have been made since the last tag");
-        goto cleanup_post_tag;
+    if (persist && cache->added_len > 0 && corel_cache_write(cache) != 0) {
+        BOAST_ERR("Could not write the classification cache %s", cache->path);
     }
-    if (args.dry_run) {
-        BOAST("[DRY RUN] Creating tag %s", version_name);
-    } else {
-        corel_tag_now(version_name, "HEAD", repository);
+    if (cache->map) {
+        munmap((void *)cache->map, cache->map_size);
     }
+    free(cache->added);
+    free(cache->path);
+    free(cache);
+}
 
-cleanup_post_tag:
-    free(version_name);
-    git_strarray_free(&tag_names);
-    git_commit_free(latest_tag_commit);
-
-cleanup:
-    regfree(&semver_regex);
-    if (commits) {
-        corel_commit_array_free(commits);
+/* Merges the new filters into the index file and swaps it in atomically */
+static int corel_bloom_save(corel_bloom *bloom, corel_bloom_entry *added, size_t added_len, const git_oid *tip) {
+    corel_state_mkdir(bloom->path);
+    char tmp_path[strlen(bloom->path) + sizeof(".lock")];
+    sprintf(tmp_path, "%s.lock", bloom->path);
+    FILE *out = corel_state_lock(tmp_path, "wbx");
+    if (!out) {
+        return 1;
     }
-    if (repository) {
+    int err = corel_bloom_write(bloom, added, added_len, tip, out);
+    err = fclose(out) != 0 || err || rename(tmp_path, bloom->path) != 0;
+    if (err) {
+        unlink(tmp_path);
+    }
+    return err;
+}
+
+/* Brings the index up to date with HEAD and writes it back. Only the commits the last update did not reach from its HEAD
+ * get diffed, so the first update diffs every commit in the repository, not just the range being released */
+static void corel_bloom_update(corel_bloom *bloom, git_repository *repository) {
+    git_oid head;
+    git_revwalk *walk;
+    if (git_reference_name_to_id(&head, repository, "HEAD") != 0 || git_revwalk_new(&walk, repository) != 0) {
+        return;
+    }
+    git_revwalk_push(walk, &head);
+    if (bloom->map) {
+        git_oid tip;
+        git_oid_fromraw(&tip, bloom->map + 16);
+        git_revwalk_hide(walk, &tip);
+    }
+
+    size_t added_len = 0;
+    size_t added_capacity = 64;
+    corel_bloom_entry *added = malloc(added_capacity * sizeof(corel_bloom_entry));
+    git_oid oid;
+    while (git_revwalk_next(&oid, walk) == 0) {
+        if (corel_bloom_find(bloom, &oid) >= 0) {
+            continue;
+        }
+        if (added_len == added_capacity) {
+            added_capacity *= 2;
+            added = realloc(added, added_capacity * sizeof(corel_bloom_entry));
+        }
+        if (corel_bloom_compute(&added[added_len], repository, &oid) == 0) {
+            added_len++;
+        }
+    }
+    git_revwalk_free(walk);
+
+    if (added_len > 0) {
+        BOAST("Indexed the changed paths of %lu commit(s)", added_len);
+        if (corel_bloom_save(bloom, added, added_len, &head) == 0) {
+            corel_bloom_unmap(bloom);
+            corel_bloom_map(bloom);
+        } else {
+            BOAST_ERR("Could not write the changed-path index %s", bloom->path);
+        }
+    }
+    for (size_t i = 0; i < added_len; i++) {
+        free(added[i].filter);
+    }
+    free(added);
+}
+
+/* Without update the index is used as it is, commits it does not know yet fall back to comparing trees */
+corel_bloom *corel_bloom_open(git_repository *repository, bool update) {
+    corel_bloom *bloom = calloc(1, sizeof(corel_bloom));
+    bloom->path = corel_state_path(repository, BLOOM_FILE);
+    if (corel_bloom_map(bloom) != 0) {
+        BOAST_DBG("Changed-path index is unusable, starting over");
+    }
+    if (update) {
+        corel_bloom_update(bloom, repository);
+    }
+    return bloom;
+}
+
+/* Where the last run stopped: everything between base and head has been analyzed and came out as highest. A run
+ * whose tag still points at base and whose HEAD descends from head only has to walk the commits in between */
+typedef struct {
+    git_oid head;
+    git_oid base;
+    COREL_RELEASE_BUMP highest;
+    u_int64_t count;
+    bool valid;
+} corel_checkpoint;
+
+int corel_checkpoint_load(corel_checkpoint *out, git_repository *repository) {
+    memset(out, 0, sizeof(corel_checkpoint));
+    char *path = corel_state_path(repository, CHECKPOINT_FILE);
+    FILE *in = fopen(path, "r");
+    free(path);
+    if (!in) {
+        return 1;
+    }
+
+    char head[GIT_OID_SHA1_HEXSIZE + 1];
+    char base[GIT_OID_SHA1_HEXSIZE + 1];
+    int highest;
+    unsigned long count;
+    u_int64_t rules_hash;
+    int fields = fscanf(in, "head %40s\nbase %40s\nbump %d\ncount %lu\nrules %lx\n", head, base, &highest, &count, &rules_hash);
+    fclose(in);
+
+    if (fields != 5 || rules_hash != corel_checkpoint_hash() || highest < MAJOR || highest > NONE || git_oid_fromstr(&out->head, head) != 0 ||
+        git_oid_fromstr(&out->base, base) != 0) {
+        BOAST_DBG("Checkpoint is unusable, starting over");
+        return 1;
+    }
+    out->highest = highest;
+    out->count = count;
+    out->valid = true;
+    return 0;
+}
+
+int corel_checkpoint_save(corel_checkpoint *checkpoint, git_repository *repository) {
+    char *path = corel_state_path(repository, CHECKPOINT_FILE);
+    char tmp_path[strlen(path) + sizeof(".lock")];
+    sprintf(tmp_path, "%s.lock", path);
+    corel_state_mkdir(path);
+
+    int err = 1;
+    FILE *out = corel_state_lock(tmp_path, "wx");
+    if (out) {
+        char head[GIT_OID_SHA1_HEXSIZE + 1];
+        char base[GIT_OID_SHA1_HEXSIZE + 1];
+        git_oid_tostr(head, sizeof(head), &checkpoint->head);
+        git_oid_tostr(base, sizeof(base), &checkpoint->base);
+        fprintf(out, "head %s\nbase %s\nbump %d\ncount %lu\nrules %lx\n", head, base, checkpoint->highest, checkpoint->count, corel_checkpoint_hash());
+        err = fclose(out) != 0 || rename(tmp_path, path) != 0;
+        if (err) {
+            unlink(tmp_path);
+        }
+    }
+    free(path);
+    return err;
+}
+
+typedef struct {
+    git_repository *repository;
+    corel_reader *reader;
+    corel_cache *cache;
+    corel_bloom *bloom;
+    corel_ver *version;
+    bool count_individually;
+    COREL_RELEASE_BUMP highest;
+    COREL_RELEASE_BUMP stop_at;
+    bool settled; // Nothing left to walk can change the bump anymore
+    bool stopped; // The walk was cut short, the commits after it have not been counted
+    u_int64_t skipped;
+} corel_bump_state;
+
+/* Returns non-zero once the walk can stop */
+static int corel_bump_state_feed(corel_bump_state *state, COREL_RELEASE_BUMP current) {
+    if (state->count_individually) {
+        corel_ver_bump(state->version, current);
+        return 0;
+    }
+    if (current < state->highest) {
+        state->highest = current;
+    }
+    return state->highest <= state->stop_at;
+}
+
+/* Classifies a commit by its own message. Even when the caller has the commit at hand only the subject the reader
+ * fetches is looked at, that way a commit is classified the same no matter which walk got to it first and filled the
+ * cache. Returns 1 if the message could not be read */
+static int corel_classify_commit(corel_bump_state *state, const git_oid *oid, COREL_RELEASE_BUMP *out) {
+    if (corel_cache_get(state->cache, oid, out) == 0) {
+        return 0;
+    }
+    char subject[COREL_SUBJECT_MAX];
+    if (corel_reader_subject(subject, sizeof(subject), state->reader, oid) != 0) {
+        return 1;
+    }
+    *out = corel_analyze_commit_message(subject);
+    corel_cache_put(state->cache, oid, *out);
+    return 0;
+}
+
+/* Root tree of a commit, straight from the commit-graph if it has the commit */
+static int corel_commit_tree(corel_bump_state *state, const git_oid *oid, git_oid *out) {
+    corel_graph *graph = state->reader ? state->reader->graph : NULL;
+    int64_t pos = graph ? corel_graph_find(graph, oid) : -1;
+    if (pos >= 0) {
+        git_oid_fromraw(out, graph->commits + (size_t)pos * GRAPH_CDAT_SIZE);
+        return 0;
+    }
+    git_commit *commit;
+    if (git_commit_lookup(&commit, state->repository, oid) != 0) {
+        return 1;
+    }
+    git_oid_cpy(out, git_commit_tree_id(commit));
+    git_commit_free(commit);
+    return 0;
+}
+
+/* Puts the n-th parent of a commit into out. Returns 1 once there are no more parents */
+static int corel_commit_parent(corel_bump_state *state, const git_oid *oid, unsigned int n, git_oid *out) {
+    corel_graph *graph = state->reader ? state->reader->graph : NULL;
+    int64_t pos = graph ? corel_graph_find(graph, oid) : -1;
+    if (pos >= 0) {
+        u_int32_t parent;
+        if (corel_graph_parent(graph, pos, n, &parent) != 0) {
+            return 1;
+        }
+        git_oid_fromraw(out, corel_graph_oid(graph, parent));
+        return 0;
+    }
+    git_commit *commit;
+    if (git_commit_lookup(&commit, state->repository, oid) != 0) {
+        return 1;
+    }
+    int err = n < git_commit_parentcount(commit) ? 0 : 1;
+    if (err == 0) {
+        git_oid_cpy(out, git_commit_parent_id(commit, n));
+    }
+    git_commit_free(commit);
+    return err;
+}
+
+/* Steps from a tree to the entry with the given name, false if there is no such entry (or the tree is no tree) */
+static bool corel_tree_child(git_repository *repository, git_oid *oid, const char *name, size_t len) {
+    git_tree *tree;
+    if (git_tree_lookup(&tree, repository, oid) != 0) {
+        return false;
+    }
+    char component[len + 1];
+    memcpy(component, name, len);
+    component[len] = '\0';
+    const git_tree_entry *entry = git_tree_entry_byname(tree, component);
+    if (entry) {
+        git_oid_cpy(oid, git_tree_entry_id(entry));
+    }
+    git_tree_free(tree);
+    return entry != NULL;
+}
+
+/* Whether path points at something different in the two trees. Both sides descend one component at a time and the
+ * comparison ends as soon as their OIDs agree, so an untouched subtree costs nothing and blobs are never read. A NULL
+ * parent_tree is the empty tree of a root commit. */
+static bool corel_path_changed(git_repository *repository, const git_oid *tree, const git_oid *parent_tree, const char *path) {
+    git_oid current = *tree;
+    git_oid parent;
+    bool in_current = true;
+    bool in_parent = parent_tree != NULL;
+    if (parent_tree) {
+        parent = *parent_tree;
+    }
+
+    const char *component = path;
+    while (in_current || in_parent) {
+        if (in_current && in_parent && git_oid_equal(&current, &parent)) {
+            return false;
+        }
+        if (*component == '\0') {
+            return true;
+        }
+        size_t len = strcspn(component, "/");
+        in_current = in_current && corel_tree_child(repository, &current, component, len);
+        in_parent = in_parent && corel_tree_child(repository, &parent, component, len);
+        component += len + (component[len] == '/');
+    }
+    return false;
+}
+
+/* Whether the commit changed anything below one of the paths. Like git log, a merge that matches one of its parents
+ * below the paths did not change anything there, with --first-parent only the first parent is compared. */
+static bool corel_commit_touches(corel_bump_state *state, const git_oid *oid, char **paths, size_t path_count) {
+    if (path_count == 0) {
+        return true;
+    }
+    // A definite no from the filter means nothing changed against the first parent, that rules out merges as well
+    bool maybe = false;
+    bool known = state->bloom != NULL;
+    for (size_t i = 0; i < path_count && known && !maybe; i++) {
+        int answer = corel_bloom_query(state->bloom, oid, paths[i]);
+        known = answer >= 0;
+        maybe = answer == 1;
+    }
+    if (known && !maybe) {
+        return false;
+    }
+
+    git_oid tree;
+    if (corel_commit_tree(state, oid, &tree) != 0) {
+        return true;
+    }
+
+    git_oid parent;
+    git_oid parent_tree;
+    unsigned int n = 0;
+    for (; corel_commit_parent(state, oid, n, &parent) == 0 && corel_commit_tree(state, &parent, &parent_tree) == 0; n++) {
+        bool changed = false;
+        for (size_t i = 0; i < path_count && !changed; i++) {
+            changed = corel_path_changed(state->repository, &tree, &parent_tree, paths[i]);
+        }
+        if (!changed) {
+            return false;
+        }
+        if (args.first_parent) {
+            return true;
+        }
+    }
+    if (n > 0) {
+        return true;
+    }
+    for (size_t i = 0; i < path_count; i++) {
+        if (corel_path_changed(state->repository, &tree, NULL, paths[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* With --path only commits that changed one of the paths count */
+static bool corel_commit_in_scope(corel_bump_state *state, const git_oid *oid) {
+    return corel_commit_touches(state, oid, args.paths, args.path_count);
+}
+
+/* The highest bump among the commits a merge brought in, i.e. everything its other parents reach but the first does not.
+ * With --path only the ones that changed one of the paths count, like in the walk itself */
+static COREL_RELEASE_BUMP corel_branch_bump(corel_bump_state *state, git_commit *merge) {
+    git_revwalk *walk;
+    if (git_revwalk_new(&walk, state->repository) != 0) {
+        return NONE;
+    }
+    git_revwalk_hide(walk, git_commit_parent_id(merge, 0));
+    for (unsigned int i = 1; i < git_commit_parentcount(merge); i++) {
+        git_revwalk_push(walk, git_commit_parent_id(merge, i));
+    }
+
+    COREL_RELEASE_BUMP highest = NONE;
+    git_oid oid;
+    while (highest != MAJOR && git_revwalk_next(&oid, walk) == 0) {
+        COREL_RELEASE_BUMP bump;
+        if (!corel_commit_in_scope(state, &oid)) {
+            continue;
+        }
+        if (corel_classify_commit(state, &oid, &bump) == 0 && bump < highest) {
+            highest = bump;
+        }
+    }
+    git_revwalk_free(walk);
+    return highest;
+}
+
+/* With --first-parent a merge is all that is left of the branch it merged. Depending on --merge-bump it is classified by
+ * its message and the PR title in its body, or by the branch itself. These do not go into the cache, they depend on the
+ * settings. Returns 1 if the commit is no merge. */
+static int corel_classify_merge(corel_bump_state *state, const git_oid *oid, git_commit *commit, COREL_RELEASE_BUMP *out) {
+    // The commit-graph knows whether there is a second parent without reading the commit
+    corel_graph *graph = state->reader ? state->reader->graph : NULL;
+    int64_t pos = graph ? corel_graph_find(graph, oid) : -1;
+    u_int32_t second;
+    if (pos >= 0 && corel_graph_parent(graph, pos, 1, &second) != 0) {
+        return 1;
+    }
+
+    git_commit *looked_up = NULL;
+    if (!commit) {
+        if (git_commit_lookup(&looked_up, state->repository, oid) != 0) {
+            return 1;
+        }
+        commit = looked_up;
+    }
+    int err = 1;
+    if (git_commit_parentcount(commit) > 1) {
+        err = 0;
+        if (args.merge_bump == MERGE_BUMP_BRANCH) {
+            *out = corel_branch_bump(state, commit);
+        } else {
+            *out = corel_analyze_commit_message(git_commit_message(commit));
+            const char *title = git_commit_body(commit);
+            if (title) {
+                COREL_RELEASE_BUMP title_bump = corel_analyze_commit_message(title);
+                *out = title_bump < *out ? title_bump : *out;
+            }
+        }
+    }
+    git_commit_free(looked_up);
+    return err;
+}
+
+static int corel_classify(corel_bump_state *state, const git_oid *oid, git_commit *commit, COREL_RELEASE_BUMP *out) {
+    if (args.first_parent && corel_classify_merge(state, oid, commit, out) == 0) {
+        return 0;
+    }
+    return corel_classify_commit(state, oid, out);
+}
+
+static int corel_bump_commit_cb(const git_oid *oid, void *payload) {
+    corel_bump_state *state = payload;
+    COREL_RELEASE_BUMP bump;
+    if (!corel_commit_in_scope(state, oid)) {
+        state->skipped++;
+        return 0;
+    }
+    // MAJOR still walks to the end for the count, the remaining commits just are not read anymore
+    if (state->settled || corel_classify(state, oid, NULL, &bump) != 0) {
+        return 0;
+    }
+    state->settled = corel_bump_state_feed(state, bump);
+    state->stopped = state->settled && state->stop_at != MAJOR;
+    return state->stopped;
+}
+
+/* Picks up where the checkpoint left off if it still describes since..HEAD. Returns the commit to resume from or NULL
+ * when everything has to be walked again */
+static const git_oid *corel_checkpoint_resume(corel_checkpoint *checkpoint, git_repository *repository, git_commit *since, const git_oid *head) {
+    if (!checkpoint->valid || !since || !git_oid_equal(&checkpoint->base, git_commit_id(since))) {
+        return NULL;
+    }
+    if (!git_oid_equal(&checkpoint->head, head) && git_graph_descendant_of(repository, head, &checkpoint->head) != 1) {
+        BOAST_DBG("History has been rewritten since the checkpoint, walking everything");
+        return NULL;
+    }
+    return &checkpoint->head;
+}
+
+/* Walks since..HEAD and bumps the version while the commits come off the walk, so no commit outlives its classification.
+ * Unless the commits are counted individually, the walk stops as soon as a bump of at least stop_at has been seen. Pass
+ * MAJOR to get the exact version and commit count, nothing can outrank it anyways, so once it shows up the rest of the
+ * walk only counts.
+ * With a checkpoint only the commits made since it are walked, and it gets moved to HEAD afterwards. It is only valid
+ * again if the walk was not cut short, the caller decides whether to save it.
+ * Returns the number of commits since the tag, or only the ones walked before stopping for anything but MAJOR. */
+u_int64_t corel_bump_version(corel_ver *version, git_repository *repository, corel_cache *cache, corel_bloom *bloom, corel_checkpoint *checkpoint,
+                             git_commit *since, bool count_individually, COREL_RELEASE_BUMP stop_at) {
+    corel_reader *reader = NULL;
+    if (corel_reader_open(&reader, repository) != 0) {
+        BOAST_ERR("Could not open the object database");
+        return 0;
+    }
+    char *version_old = corel_ver_tostr(version);
+
+    git_oid head;
+    bool has_head = git_reference_name_to_id(&head, repository, "HEAD") == 0;
+    const git_oid *resume = NULL;
+    u_int64_t resumed = 0;
+    if (checkpoint && has_head && !count_individually) {
+        resume = corel_checkpoint_resume(checkpoint, repository, since, &head);
+    }
+
+    corel_bump_state state = {
+        .repository = repository,
+        .reader = reader,
+        .cache = cache,
+        .bloom = bloom,
+        .version = version,
+        .count_individually = count_individually,
+        .highest = resume ? checkpoint->highest : NONE,
+        .stop_at = stop_at,
+    };
+    if (resume) {
+        resumed = checkpoint->count;
+        BOAST_DBG("Resuming after %lu already analyzed commit(s)", resumed);
+    }
+    // Only the per-commit bumps depend on the order, the highest bump is the same no matter where it shows up
+    unsigned int sorting = count_individually ? COREL_SORT_CHRONOLOGICAL : GIT_SORT_NONE;
+    int64_t walked = -1;
+    corel_bitmap *bitmap = NULL;
+    // Bitmaps only know about reachability, not which parent got there
+    for (size_t i = 0; !count_individually && has_head && !args.first_parent && !bitmap && i < reader->packs->len; i++) {
+        bitmap = corel_bitmap_open(reader->packs->entries[i]);
+    }
+    if (bitmap) {
+        walked = corel_bitmap_walk(bitmap, repository, &head, since, resume, corel_bump_commit_cb, &state);
+        corel_bitmap_free(bitmap);
+    }
+    if (walked < 0 && !count_individually && has_head) {
+        if (!reader->graph) {
+            BOAST_DBG("No commit-graph found, walking commit by commit (git commit-graph write speeds this up)");
+        } else if ((walked = corel_graph_walk(reader->graph, &head, since, resume, args.first_parent, corel_bump_commit_cb, &state)) < 0) {
+            BOAST_DBG("The commit-graph is older than the commits to walk, walking commit by commit");
+        }
+    }
+    if (walked < 0) {
+        walked = corel_commit_walk(repository, since, resume, sorting, corel_bump_commit_cb, &state);
+    }
+    u_int64_t count = resumed + walked - state.skipped;
+    // Not from the walks, they hand out every commit before --path had its say. A walk cut short has no total
+    if (count > 0 && !state.stopped) {
+        BOAST("Woaah, you have %lu commit(s)", count);
+    }
+
+    if (!count_individually) {
+        corel_ver_bump(version, state.highest);
+    }
+    if (checkpoint && !count_individually && since && has_head) {
+        checkpoint->head = head;
+        checkpoint->base = *git_commit_id(since);
+        checkpoint->highest = state.highest;
+        checkpoint->count = count;
+        // An early stop leaves commits unseen, neither their bumps nor their number would be known on the next run
+        checkpoint->valid = !state.stopped;
+    }
+
+    char *version_new = corel_ver_tostr(version);
+    BOAST_DBG("Bumped Version from %s->%s in %lu commits", version_old, version_new, count);
+    free(version_old);
+    free(version_new);
+    corel_reader_free(reader);
+    return count;
+}
+
+/* Creates all tags pointing at rev in one ref transaction. Every ref is locked and checked before anything gets written, so a
+ * tag that exists already (GIT_EEXISTS) or is locked by someone else (GIT_ELOCKED) leaves the repository untouched */
+int corel_tag_many(char **tag_names, size_t count, const char *rev, git_repository *repository) {
+    git_object *target = NULL;
+    if (git_revparse_single(&target, repository, rev) != 0) {
+        ERROR(ERR_TAG_NOT_CREATED)
+        BOAST_ERR("Could not resolve %s: %s", rev, git_error_last()->message);
+        return -1;
+    }
+
+    git_transaction *transaction = NULL;
+    char refname[PATH_MAX];
+    int err = git_transaction_new(&transaction, repository);
+    for (size_t i = 0; err == 0 && i < count; i++) {
+        snprintf(refname, sizeof(refname), TAG_REF_PREFIX "%s", tag_names[i]);
+        int valid = 0;
+        if (git_reference_name_is_valid(&valid, refname) != 0 || !valid) {
+            BOAST_ERR("%s is not a valid tag name", tag_names[i]);
+            err = -1;
+            break;
+        }
+        if ((err = git_transaction_lock_ref(transaction, refname)) != 0) {
+            BOAST_ERR("Could not lock %s: %s", refname, git_error_last()->message);
+            break;
+        }
+        // Holding the lock, nobody can create it between this check and the commit
+        git_reference *existing = NULL;
+        if (git_reference_lookup(&existing, repository, refname) == 0) {
+            BOAST_ERR("Tag %s exists already", tag_names[i]);
+            git_reference_free(existing);
+            err = GIT_EEXISTS;
+            break;
+        }
+        err = git_transaction_set_target(transaction, refname, git_object_id(target), NULL, NULL);
+    }
+    if (err == 0 && (err = git_transaction_commit(transaction)) != 0) {
+        BOAST_ERR("Could not write the tags: %s", git_error_last()->message);
+    }
+    // Freeing an uncommitted transaction drops its locks
+    git_transaction_free(transaction);
+    git_object_free(target);
+
+    if (err != 0) {
+        ERROR(ERR_TAG_NOT_CREATED)
+        BOAST_ERR("Failed to create %lu tag(s)", count);
+        return err;
+    }
+    BOAST_DBG("Created %lu tag(s) at %s", count, rev);
+    return 0;
+}
+
+typedef struct {
+    unsigned int tried; // Credential types handed out already
+    size_t rejected;
+    unsigned int objects;
+} corel_push_state;
+
+/* The ssh-agent for ssh remotes, COREL_GIT_USERNAME and COREL_GIT_TOKEN for https and the platform's own (NTLM, Negotiate)
+ * otherwise. Every type is only offered once, being asked again means the remote turned it down */
+static int corel_credentials_cb(git_credential **out, const char *url, const char *username_from_url, unsigned int allowed_types, void *payload) {
+    corel_push_state *push = payload;
+    const char *username = username_from_url ? username_from_url : getenv("COREL_GIT_USERNAME");
+    const char *token = getenv("COREL_GIT_TOKEN");
+    unsigned int untried = allowed_types & ~push->tried;
+    if (untried & GIT_CREDENTIAL_USERNAME) {
+        push->tried |= GIT_CREDENTIAL_USERNAME;
+        return git_credential_username_new(out, username ? username : "git");
+    }
+    if (untried & GIT_CREDENTIAL_SSH_KEY) {
+        push->tried |= GIT_CREDENTIAL_SSH_KEY;
+        return git_credential_ssh_key_from_agent(out, username ? username : "git");
+    }
+    if ((untried & GIT_CREDENTIAL_USERPASS_PLAINTEXT) && token) {
+        push->tried |= GIT_CREDENTIAL_USERPASS_PLAINTEXT;
+        // Token based hosts do not care about the user name, but it cannot be empty
+        return git_credential_userpass_plaintext_new(out, username ? username : "git", token);
+    }
+    if (untried & GIT_CREDENTIAL_DEFAULT) {
+        push->tried |= GIT_CREDENTIAL_DEFAULT;
+        return git_credential_default_new(out);
+    }
+    BOAST_ERR("No credentials left to try for %s", url);
+    return GIT_EAUTH;
+}
+
+/* Called once per pushed ref, a status means the remote refused it */
+static int corel_push_update_cb(const char *refname, const char *status, void *payload) {
+    corel_push_state *push = payload;
+    if (status) {
+        BOAST_ERR("The remote rejected %s: %s", refname, status);
+        push->rejected++;
+    }
+    return 0;
+}
+
+static int corel_push_progress_cb(unsigned int current, unsigned int total, size_t bytes, void *payload) {
+    (void)current;
+    (void)bytes;
+    corel_push_state *push = payload;
+    push->objects = total;
+    return 0;
+}
+
+/* Pushes exactly the given tags, one refspec each, in a single push. Returns GIT_EEXISTS if the remote has any of them already. The tagged commits are on the remote already in the usual
+ * case, so the pack that goes out is empty. The advertisement of the same connection is checked first, because the remote
+ * would happily move a tag of the same name forward */
+int corel_push_tags(char **tag_names, size_t count, git_repository *repository) {
+    const char *remote_name = args.remote ? args.remote : "origin";
+    git_remote *remote = NULL;
+    if (git_remote_lookup(&remote, repository, remote_name) != 0) {
+        if (!args.remote) {
+            BOAST("There is no %s remote, the tags stay local", remote_name);
+            return 0;
+        }
+        ERROR(ERR_TAG_NOT_PUSHED)
+        BOAST_ERR("Failed to lookup remote %s", remote_name);
+        return -1;
+    }
+
+    corel_push_state push = {0};
+    git_push_options options;
+    git_push_options_init(&options, GIT_PUSH_OPTIONS_VERSION);
+    options.callbacks.credentials = corel_credentials_cb;
+    options.callbacks.push_update_reference = corel_push_update_cb;
+    options.callbacks.push_transfer_progress = corel_push_progress_cb;
+    options.callbacks.payload = &push;
+
+    const git_remote_head **heads = NULL;
+    size_t head_count = 0;
+    int err = git_remote_connect(remote, GIT_DIRECTION_PUSH, &options.callbacks, &options.proxy_opts, &options.custom_headers);
+    if (err == 0) {
+        err = git_remote_ls(&heads, &head_count, remote);
+    }
+    if (err != 0) {
+        ERROR(ERR_TAG_NOT_PUSHED)
+        BOAST_ERR("Failed to connect to %s: %s", remote_name, git_error_last()->message);
+        git_remote_free(remote);
+        return err;
+    }
+
+    char **refspecs = malloc(count * sizeof(char *));
+    size_t refspec_count = 0;
+    char refname[PATH_MAX];
+    for (size_t i = 0; i < count; i++) {
+        snprintf(refname, sizeof(refname), TAG_REF_PREFIX "%s", tag_names[i]);
+        git_oid local;
+        if (git_reference_name_to_id(&local, repository, refname) != 0) {
+            BOAST_ERR("Tag %s does not exist", tag_names[i]);
+            err = -1;
+            break;
+        }
+        const git_remote_head *existing = NULL;
+        for (size_t h = 0; h < head_count && !existing; h++) {
+            existing = strcmp(heads[h]->name, refname) == 0 ? heads[h] : NULL;
+        }
+        if (existing && git_oid_equal(&existing->oid, &local)) {
+            BOAST_DBG("%s has %s already", remote_name, tag_names[i]);
+            continue;
+        }
+        if (existing) {
+            BOAST_ERR("%s has a different %s already", remote_name, tag_names[i]);
+            err = GIT_EEXISTS;
+            break;
+        }
+        size_t len = 2 * strlen(refname) + 2;
+        refspecs[refspec_count] = malloc(len);
+        snprintf(refspecs[refspec_count++], len, "%s:%s", refname, refname);
+    }
+
+    if (err == 0 && refspec_count > 0) {
+        // Still connected, so this reuses the advertisement from above instead of negotiating again
+        const git_strarray refspec_array = {refspecs, refspec_count};
+        err = git_remote_push(remote, &refspec_array, &options);
+        if (err != 0) {
+            BOAST_ERR("Failed to push to %s: %s", remote_name, git_error_last()->message);
+        } else if (push.rejected > 0) {
+            // Most likely someone pushed the same tag between the advertisement and the push
+            BOAST_ERR("%s rejected %lu of %lu tag(s)", remote_name, push.rejected, refspec_count);
+            err = GIT_EEXISTS;
+        } else {
+            BOAST("Pushed %lu tag(s) to %s", refspec_count, remote_name);
+            BOAST_DBG("The pack had %u object(s)", push.objects);
+        }
+    }
+    if (err != 0) {
+        ERROR(ERR_TAG_NOT_PUSHED)
+    }
+
+    for (size_t i = 0; i < refspec_count; i++) {
+        free(refspecs[i]);
+    }
+    free(refspecs);
+    git_remote_disconnect(remote);
+    git_remote_free(remote);
+    return err;
+}
+
+int corel_tag_now(char *tag_name, char *rev, git_repository *repository) {
+    int err = corel_tag_many(&tag_name, 1, rev, repository);
+    if (err == 0 && !args.no_push) {
+        err = corel_push_tags(&tag_name, 1, repository);
+    }
+    return err;
+}
+
+/* Leaves the repository cheaper to walk for the next run: a fresh commit-graph of everything reachable from the refs and,
+ * once fetches have piled up enough packs, a multi-pack-index so lookups only have to search one index */
+void corel_write_graph(git_repository *repository) {
+    git_buf objects_dir = {0};
+    if (git_repository_item_path(&objects_dir, repository, GIT_REPOSITORY_ITEM_OBJECTS) != 0) {
+        BOAST_ERR("Could not find the object database");
+        return;
+    }
+    char path[PATH_MAX];
+
+    git_commit_graph_writer *graph_writer = NULL;
+    git_revwalk *walk = NULL;
+    snprintf(path, sizeof(path), "%sinfo", objects_dir.ptr);
+    mkdir(path, 0755);
+    if (git_commit_graph_writer_new(&graph_writer, path, NULL) != 0 || git_revwalk_new(&walk, repository) != 0 ||
+        git_revwalk_push_glob(walk, "refs/*") != 0 || git_revwalk_push_head(walk) != 0 ||
+        git_commit_graph_writer_add_revwalk(graph_writer, walk) != 0 || git_commit_graph_writer_commit(graph_writer) != 0) {
+        BOAST_ERR("Could not write the commit-graph: %s", git_error_last()->message);
+    } else {
+        BOAST("Refreshed the commit-graph");
+    }
+    git_revwalk_free(walk);
+    git_commit_graph_writer_free(graph_writer);
+
+    snprintf(path, sizeof(path), "%spack", objects_dir.ptr);
+    git_buf_dispose(&objects_dir);
+    DIR *dir = opendir(path);
+    if (!dir) {
+        return;
+    }
+    git_midx_writer *midx_writer = NULL;
+    unsigned long packs = 0;
+    int err = git_midx_writer_new(&midx_writer, path);
+    struct dirent *entry;
+    while (err == 0 && (entry = readdir(dir)) != NULL) {
+        size_t len = strlen(entry->d_name);
+        if (len < strlen(".idx") || strcmp(entry->d_name + len - strlen(".idx"), ".idx") != 0) {
+            continue;
+        }
+        err = git_midx_writer_add(midx_writer, entry->d_name);
+        packs++;
+    }
+    closedir(dir);
+
+    if (err == 0 && packs > args.midx_packs) {
+        err = git_midx_writer_commit(midx_writer);
+        if (err == 0) {
+            BOAST("Wrote a multi-pack-index over %lu packs", packs);
+        }
+    }
+    if (err != 0) {
+        BOAST_ERR("Could not write the multi-pack-index: %s", git_error_last()->message);
+    }
+    git_midx_writer_free(midx_writer);
+}
+
+/* What the run over one repository came to, --batch prints it as one line */
+typedef struct {
+    corel_ver version;
+    bool has_version;
+    u_int64_t commits;
+    bool tagged;
+} corel_result;
+
+void corel_try_auto_init(git_repository *repository, corel_cache *cache, corel_bloom *bloom, corel_result *result) {
+    if (!args.auto_init_tag) {
+        ERROR(ERR_NO_TAGS_NO_AUTO_INIT)
+        BOAST("No tags have been created yet and --auto-init-tag was not provided.");
+        return;
+    }
+
+    BOAST("No tags have been created yet. Figuring out initial version, starting from %s", args.init_version);
+    corel_taginfo version;
+    if (corel_taginfo_parse(&version, args.init_version) != 0) {
+        ERROR(ERR_INVALID_INIT_TAG)
+        BOAST_ERR("Could not parse initial version %s", args.init_version);
+        return;
+    }
+
+    result->commits = corel_bump_version(&version.ver, repository, cache, bloom, NULL, GIT_COMMIT_HEAD, true, MAJOR);
+    result->version = version.ver;
+    result->has_version = true;
+
+    if (!args.dry_run) {
+        char *tag_name = corel_tag_name(&version.ver);
+        result->tagged = corel_tag_now(tag_name, "HEAD", repository) == 0;
+        free(tag_name);
+        if (args.write_graph) {
+            corel_write_graph(repository);
+        }
+    }
+}
+
+/* Called for every tag matching --tag-pattern that is a version. The tag and its name only live during the call.
+ * Returning non-zero stops the iteration. */
+typedef int (*corel_tag_cb)(corel_taginfo *tag, void *payload);
+
+/* Parses a tag ref whose name has prefix_len bytes before the version. The name points into the ref. */
+static int corel_taginfo_from_ref(corel_taginfo *out, git_reference *ref, size_t prefix_len) {
+    // Packed annotated tags come with their peeled commit from the "^" line in packed-refs, no object read needed
+    const git_oid *peeled = git_reference_target_peel(ref);
+    const git_oid *target = peeled ? peeled : git_reference_target(ref);
+    const char *name = git_reference_name(ref) + strlen(TAG_REF_PREFIX);
+    if (!target || strlen(name) < prefix_len || corel_taginfo_parse(out, name + prefix_len) != 0) {
+        return 1;
+    }
+    out->name = (char *)name;
+    out->peeled = peeled != NULL;
+    git_oid_cpy(&out->target, target);
+    return 0;
+}
+
+/* --remote-tags: the tags only the remote has, straight from its ref advertisement. Nothing is fetched, the advertisement
+ * already carries the peeled commit of annotated tags as a name^{} entry right after the tag. Returns the number of matching
+ * remote only tags, versions or not */
+static size_t corel_remote_tags_foreach(git_repository *repository, const char *glob, corel_tag_cb callback, void *payload) {
+    const char *remote_name = args.remote ? args.remote : "origin";
+    git_remote *remote = NULL;
+    corel_push_state auth = {0};
+    git_remote_callbacks callbacks;
+    git_remote_init_callbacks(&callbacks, GIT_REMOTE_CALLBACKS_VERSION);
+    callbacks.credentials = corel_credentials_cb;
+    callbacks.payload = &auth;
+
+    const git_remote_head **heads = NULL;
+    size_t head_count = 0;
+    if (git_remote_lookup(&remote, repository, remote_name) != 0 || git_remote_connect(remote, GIT_DIRECTION_FETCH, &callbacks, NULL, NULL) != 0 ||
+        git_remote_ls(&heads, &head_count, remote) != 0) {
+        BOAST_ERR("Could not list the tags of %s: %s", remote_name, git_error_last()->message);
+        git_remote_free(remote);
+        return 0;
+    }
+    git_odb *odb = NULL;
+    git_repository_odb(&odb, repository);
+
+    size_t count = 0;
+    for (size_t h = 0; h < head_count; h++) {
+        const char *refname = heads[h]->name;
+        size_t len = strlen(refname);
+        git_oid local;
+        if (fnmatch(glob, refname, 0) != 0 || (len > 3 && strcmp(refname + len - 3, "^{}") == 0) ||
+            git_reference_name_to_id(&local, repository, refname) == 0) {
+            continue;
+        }
+        count++;
+
+        corel_taginfo tag;
+        const char *name = refname + strlen(TAG_REF_PREFIX);
+        if (strlen(name) < args.tag_prefix_len || corel_taginfo_parse(&tag, name + args.tag_prefix_len) != 0) {
+            continue;
+        }
+        const git_remote_head *peeled = h + 1 < head_count ? heads[h + 1] : NULL;
+        if (peeled && !(strncmp(peeled->name, refname, len) == 0 && strcmp(peeled->name + len, "^{}") == 0)) {
+            peeled = NULL;
+        }
+        tag.name = (char *)name;
+        tag.peeled = true;
+        git_oid_cpy(&tag.target, peeled ? &peeled->oid : &heads[h]->oid);
+        tag.missing = !odb || !git_odb_exists(odb, &tag.target);
+        if (callback(&tag, payload)) {
+            break;
+        }
+    }
+    git_odb_free(odb);
+    git_remote_disconnect(remote);
+    git_remote_free(remote);
+    return count;
+}
+
+/* The glob is handed to the ref iterator, which skips everything else before a reference is even allocated.
+ * Returns the number of matching tags, versions or not */
+size_t corel_tags_foreach(git_repository *repository, bool remote_tags, corel_tag_cb callback, void *payload) {
+    char glob[strlen(TAG_REF_PREFIX) + strlen(args.tag_pattern) + 1];
+    sprintf(glob, "%s%s", TAG_REF_PREFIX, args.tag_pattern);
+
+    git_reference_iterator *iter;
+    if (git_reference_iterator_glob_new(&iter, repository, glob) != 0) {
+        return 0;
+    }
+
+    size_t count = 0;
+    git_reference *ref;
+    while (git_reference_next(&ref, iter) == 0) {
+        corel_taginfo tag;
+        count++;
+
+        int stop = 0;
+        if (corel_taginfo_from_ref(&tag, ref, args.tag_prefix_len) == 0) {
+            stop = callback(&tag, payload);
+        }
+        git_reference_free(ref);
+        if (stop) {
+            break;
+        }
+    }
+    git_reference_iterator_free(iter);
+    if (remote_tags) {
+        count += corel_remote_tags_foreach(repository, glob, callback, payload);
+    }
+    return count;
+}
+
+typedef struct {
+    corel_taginfo latest;
+    bool found;
+    char *name;
+    size_t name_capacity;
+    // The highest tag whose commit we have, only differs from latest with --remote-tags
+    corel_taginfo base;
+    bool base_found;
+    char *base_name;
+    size_t base_name_capacity;
+} corel_latest_tag_state;
+
+static int corel_latest_tag_cb(corel_taginfo *tag, void *payload) {
+    corel_latest_tag_state *state = payload;
+    corel_taginfo copy = *tag;
+    if (!state->found || corel_taginfo_cmp(tag, &state->latest) > 0) {
+        // Keep our own copy of the best name so far, growing the buffer only when needed
+        corel_taginfo_rebase(&copy, &state->name, &state->name_capacity);
+        state->latest = copy;
+        state->found = true;
+    }
+    if (!tag->missing && (!state->base_found || corel_taginfo_cmp(tag, &state->base) > 0)) {
+        corel_taginfo_rebase(tag, &state->base_name, &state->base_name_capacity);
+        state->base = *tag;
+        state->base_found = true;
+    }
+    return 0;
+}
+
+/* Finds the highest version tag and remembers its target, so it never has to be looked up by name again */
+corel_taginfo *corel_latest_tag(git_repository *repository, bool remote_tags) {
+    corel_latest_tag_state state = {0};
+    // Not inside BOAST, --quiet would skip the enumeration along with the message
+    size_t tag_count = corel_tags_foreach(repository, remote_tags, corel_latest_tag_cb, &state);
+    BOAST("Tags: %lu", tag_count);
+
+    // Someone else released from commits we have not fetched. Their version is the one to bump, the commits since our own
+    // newest tag are the ones that bump it
+    if (state.found && state.latest.missing && state.base_found) {
+        BOAST("%s has not been fetched, counting the commits since %s", state.latest.name, state.base.name);
+        state.latest.target = state.base.target;
+        state.latest.peeled = state.base.peeled;
+        state.latest.missing = false;
+    }
+    corel_taginfo *result = state.found ? corel_taginfo_dup(&state.latest) : NULL;
+    free(state.name);
+    free(state.base_name);
+    return result;
+}
+
+typedef struct {
+    git_repository *repository;
+    corel_taginfo_array *tags;
+    corel_oidmap by_commit; // Commit -> index of its highest tag
+    int fully_peeled;
+} corel_tag_map;
+
+static int corel_tag_map_cb(corel_taginfo *tag, void *payload) {
+    corel_tag_map *map = payload;
+    if (corel_taginfo_peel(tag, map->repository, &map->fully_peeled) != 0) {
+        return 0;
+    }
+    u_int64_t *existing = corel_oidmap_get(&map->by_commit, &tag->target);
+    if (existing && corel_taginfo_cmp(tag, map->tags->entries[*existing]) <= 0) {
+        return 0;
+    }
+    corel_oidmap_put(&map->by_commit, &tag->target, map->tags->len);
+    corel_taginfo_array_push(map->tags, corel_taginfo_dup(tag));
+    return 0;
+}
+
+#define DESCRIBE_UNINTERESTING 1
+#define DESCRIBE_DONE 2
+
+typedef struct {
+    git_oid oid;
+    u_int32_t generation;
+    u_int64_t date;
+} corel_describe_entry;
+
+/* The commits the describe walk has yet to look at, newest generation first like corel_graph_walk. Commits the
+ * commit-graph does not know are newer than all it knows, they come first and go by date among themselves */
+typedef struct {
+    corel_bump_state *state;
+    corel_describe_entry *heap;
+    size_t len;
+    size_t capacity;
+    corel_oidmap flags; // Every commit ever queued -> DESCRIBE_* flags
+    size_t interesting;
+} corel_describe_queue;
+
+static bool corel_describe_before(corel_describe_entry *a, corel_describe_entry *b) {
+    if (a->generation != b->generation) {
+        return a->generation > b->generation;
+    }
+    return a->date > b->date;
+}
+
+static void corel_describe_push(corel_describe_queue *queue, const git_oid *oid, bool uninteresting) {
+    u_int64_t *flags = corel_oidmap_get(&queue->flags, oid);
+    if (flags) {
+        if (uninteresting && !(*flags & (DESCRIBE_UNINTERESTING | DESCRIBE_DONE))) {
+            *flags |= DESCRIBE_UNINTERESTING;
+            queue->interesting--;
+        }
+        return;
+    }
+
+    corel_describe_entry entry = {.generation = UINT32_MAX};
+    git_oid_cpy(&entry.oid, oid);
+    corel_graph *graph = queue->state->reader->graph;
+    int64_t pos = graph ? corel_graph_find(graph, oid) : -1;
+    if (pos >= 0) {
+        entry.generation = corel_graph_generation(graph, pos);
+        entry.date = corel_graph_date(graph, pos);
+    } else {
+        git_commit *commit;
+        if (git_commit_lookup(&commit, queue->state->repository, oid) != 0) {
+            return;
+        }
+        entry.date = git_commit_time(commit);
+        git_commit_free(commit);
+    }
+    corel_oidmap_put(&queue->flags, oid, uninteresting ? DESCRIBE_UNINTERESTING : 0);
+    queue->interesting += !uninteresting;
+
+    if (queue->len == queue->capacity) {
+        queue->capacity *= 2;
+        queue->heap = realloc(queue->heap, queue->capacity * sizeof(corel_describe_entry));
+    }
+    size_t i = queue->len++;
+    while (i > 0 && corel_describe_before(&entry, &queue->heap[(i - 1) / 2])) {
+        queue->heap[i] = queue->heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    queue->heap[i] = entry;
+}
+
+static corel_describe_entry corel_describe_pop(corel_describe_queue *queue) {
+    corel_describe_entry top = queue->heap[0];
+    corel_describe_entry last = queue->heap[--queue->len];
+    size_t i = 0;
+    while (2 * i + 1 < queue->len) {
+        size_t child = 2 * i + 1;
+        if (child + 1 < queue->len && corel_describe_before(&queue->heap[child + 1], &queue->heap[child])) {
+            child++;
+        }
+        if (!corel_describe_before(&queue->heap[child], &last)) {
+            break;
+        }
+        queue->heap[i] = queue->heap[child];
+        i = child;
+    }
+    queue->heap[i] = last;
+    return top;
+}
+
+/* Walks back from HEAD like git describe does and stops at every tagged commit instead of walking past it. A branch that
+ * forked before one of those tags can still lead to commits the tag released, so the commits left to classify are the
+ * ones HEAD reaches minus everything any of the tags found reaches.
+ * Everything a tag the walk found reaches is marked uninteresting, and the walk ends once only uninteresting commits
+ * are queued. Going by generation, such a side branch is only followed down to where it joins the history of a tag
+ * instead of down to the root. Without a commit-graph the commit dates stand in for the generations, a skewed clock can
+ * make the walk go further than needed but never changes what gets hidden.
+ * Returns the highest of the tags the walk ran into, or NULL if none is reachable. */
+corel_taginfo *corel_describe_head(git_repository *repository, corel_cache *cache, corel_bloom *bloom, COREL_RELEASE_BUMP *highest, u_int64_t *count) {
+    corel_reader *reader = NULL;
+    if (corel_reader_open(&reader, repository) != 0) {
+        BOAST_ERR("Could not open the object database");
+        return NULL;
+    }
+    corel_tag_map map = {.repository = repository, .fully_peeled = -1};
+    corel_taginfo_array_init(&map.tags, 16);
+    corel_oidmap_init(&map.by_commit, 16);
+    size_t tag_count = corel_tags_foreach(repository, args.remote_tags, corel_tag_map_cb, &map);
+    BOAST("Tags: %lu", tag_count);
+
+    corel_bump_state state = {.repository = repository, .reader = reader, .cache = cache, .bloom = bloom, .highest = NONE, .stop_at = MAJOR};
+    corel_taginfo *nearest = NULL;
+    corel_describe_queue queue = {.state = &state, .capacity = 64};
+    queue.heap = malloc(queue.capacity * sizeof(corel_describe_entry));
+    corel_oidmap_init(&queue.flags, 1024);
+    git_revwalk *walk = NULL;
+
+    git_oid head;
+    *count = 0;
+    if (git_reference_name_to_id(&head, repository, "HEAD") != 0 || git_revwalk_new(&walk, repository) != 0) {
+        goto cleanup;
+    }
+    git_revwalk_sorting(walk, GIT_SORT_NONE);
+    if (args.first_parent) {
+        git_revwalk_simplify_first_parent(walk);
+    }
+    git_revwalk_push(walk, &head);
+    corel_describe_push(&queue, &head, false);
+
+    // Only parents are needed to find the tags, the commit-graph has them without reading any commit
+    while (queue.interesting > 0) {
+        corel_describe_entry entry = corel_describe_pop(&queue);
+        u_int64_t *flags = corel_oidmap_get(&queue.flags, &entry.oid);
+        bool uninteresting = *flags & DESCRIBE_UNINTERESTING;
+        *flags |= DESCRIBE_DONE;
+        if (!uninteresting) {
+            queue.interesting--;
+            u_int64_t *tagged = corel_oidmap_get(&map.by_commit, &entry.oid);
+            if (tagged) {
+                corel_taginfo *tag = map.tags->entries[*tagged];
+                if (!nearest || corel_taginfo_cmp(tag, nearest) > 0) {
+                    nearest = tag;
+                }
+                git_revwalk_hide(walk, &entry.oid);
+                uninteresting = true;
+            }
+        }
+
+        git_oid parent;
+        for (unsigned int p = 0; corel_commit_parent(&state, &entry.oid, p, &parent) == 0; p++) {
+            corel_describe_push(&queue, &parent, uninteresting);
+            // What a tag reaches stays hidden through every parent
+            if (args.first_parent && !uninteresting) {
+                break;
+            }
+        }
+    }
+
+    git_oid oid;
+    while (git_revwalk_next(&oid, walk) == 0) {
+        COREL_RELEASE_BUMP bump;
+        if (corel_commit_in_scope(&state, &oid)) {
+            (*count)++;
+            if (corel_classify(&state, &oid, NULL, &bump) == 0) {
+                corel_bump_state_feed(&state, bump);
+            }
+        }
+    }
+
+    if (*count > 0) {
+        BOAST("Woaah, you have %lu commit(s)", *count);
+    }
+
+cleanup:;
+    corel_taginfo *result = nearest ? corel_taginfo_dup(nearest) : NULL;
+    *highest = state.highest;
+
+    git_revwalk_free(walk);
+    free(queue.heap);
+    corel_reader_free(reader);
+    corel_oidmap_free(&queue.flags);
+    corel_oidmap_free(&map.by_commit);
+    corel_taginfo_array_free(map.tags);
+    return result;
+}
+
+/* One entry of the --components file. Components without a path cover the whole repository */
+typedef struct {
+    char *name;
+    char *path;
+    char *tag_prefix;
+    corel_taginfo *tag;
+    corel_ver version;
+    COREL_RELEASE_BUMP highest;
+    u_int64_t count;
+    // Components without a tag bump per commit like --auto-init-tag, oldest first, so the bumps wait here
+    u_int8_t *bumps;
+    size_t bumps_capacity;
+} corel_component;
+
+void corel_component_free(corel_component *component) {
+    free(component->name);
+    free(component->path);
+    free(component->tag_prefix);
+    if (component->tag) {
+        corel_taginfo_free(component->tag);
+    }
+    free(component->bumps);
+    free(component);
+}
+
+DYNAMIC_ARRAY(corel_component_array, corel_component);
+
+/* Lines look like "billing services/billing billing/v", anything after a # is a comment */
+int corel_components_parse(corel_component_array **out, const char *file) {
+    FILE *in = fopen(file, "r");
+    if (!in) {
+        return 1;
+    }
+    corel_component_array_init(out, 16);
+
+    char *line = NULL;
+    size_t line_capacity = 0;
+    int err = 0;
+    unsigned int line_no = 0;
+    while (err == 0 && getline(&line, &line_capacity, in) != -1) {
+        line_no++;
+        line[strcspn(line, "#")] = '\0';
+        char *save;
+        char *name = strtok_r(line, " \t\r\n", &save);
+        char *path = strtok_r(NULL, " \t\r\n", &save);
+        char *tag_prefix = strtok_r(NULL, " \t\r\n", &save);
+        if (!name) {
+            continue;
+        }
+        if (!path || !tag_prefix || strtok_r(NULL, " \t\r\n", &save)) {
+            BOAST_ERR("%s:%u: expected a name, a path and a tag prefix", file, line_no);
+            err = 1;
+            break;
+        }
+
+        corel_component *component = calloc(1, sizeof(corel_component));
+        component->name = strdup(name);
+        while (*path == '/') {
+            path++;
+        }
+        for (size_t len = strlen(path); len > 0 && path[len - 1] == '/'; len--) {
+            path[len - 1] = '\0';
+        }
+        component->path = *path == '\0' || strcmp(path, ".") == 0 ? NULL : strdup(path);
+        component->tag_prefix = strdup(tag_prefix);
+        component->highest = NONE;
+        corel_component_array_push(*out, component);
+    }
+    free(line);
+    fclose(in);
+    return err;
+}
+
+/* A single pass over all tags. Every tag goes to the component with the longest matching prefix, and each component keeps
+ * its highest version */
+static void corel_components_tags(git_repository *repository, corel_component_array *components) {
+    git_reference_iterator *iter;
+    if (git_reference_iterator_glob_new(&iter, repository, TAG_REF_PREFIX "*") != 0) {
+        return;
+    }
+    git_reference *ref;
+    while (git_reference_next(&ref, iter) == 0) {
+        const char *name = git_reference_name(ref) + strlen(TAG_REF_PREFIX);
+        corel_component *owner = NULL;
+        size_t owner_len = 0;
+        for (size_t i = 0; i < components->len; i++) {
+            size_t len = strlen(components->entries[i]->tag_prefix);
+            if (len >= owner_len && strncmp(name, components->entries[i]->tag_prefix, len) == 0) {
+                owner = components->entries[i];
+                owner_len = len;
+            }
+        }
+        corel_taginfo tag;
+        if (owner && corel_taginfo_from_ref(&tag, ref, owner_len) == 0 && (!owner->tag || corel_taginfo_cmp(&tag, owner->tag) > 0)) {
+            if (owner->tag) {
+                corel_taginfo_free(owner->tag);
+            }
+            owner->tag = corel_taginfo_dup(&tag);
+        }
+        git_reference_free(ref);
+    }
+    git_reference_iterator_free(iter);
+}
+
+/* Per commit: which tags reach it (bit i for component i) and whether HEAD does (the last bit) */
+typedef struct {
+    corel_oidmap index;
+    u_int64_t *masks;
+    size_t words;
+    size_t len;
+    size_t capacity;
+} corel_component_masks;
+
+static u_int64_t *corel_component_mask(corel_component_masks *masks, const git_oid *oid) {
+    u_int64_t *slot = corel_oidmap_get(&masks->index, oid);
+    if (slot) {
+        return masks->masks + *slot * masks->words;
+    }
+    if (masks->len == masks->capacity) {
+        masks->capacity *= 2;
+        masks->masks = realloc(masks->masks, masks->capacity * masks->words * sizeof(u_int64_t));
+    }
+    corel_oidmap_put(&masks->index, oid, masks->len);
+    u_int64_t *mask = masks->masks + masks->len++ * masks->words;
+    memset(mask, 0, masks->words * sizeof(u_int64_t));
+    return mask;
+}
+
+/* Walks HEAD and all component tags together, children before parents, and pushes down which tags reach each commit. A
+ * commit HEAD reaches goes to every component whose tag does not reach it and whose path it touches, so every commit is
+ * read at most once no matter how many components there are. Everything all tags reach is hidden from the walk.
+ * An untagged component that gets an initial release counts every commit HEAD reaches, so as long as there is one nothing
+ * can be hidden, and the topological sort reads and buffers all of history before handing out the first commit. Untagged
+ * components that only get reported are left out of the walk. */
+static void corel_components_walk(git_repository *repository, corel_component_array *components, corel_bump_state *state) {
+    size_t n = components->len;
+    corel_component_masks masks = {.words = n / 64 + 1, .capacity = 1024};
+    corel_oidmap_init(&masks.index, masks.capacity);
+    masks.masks = malloc(masks.capacity * masks.words * sizeof(u_int64_t));
+    size_t head_bit = n;
+#define MASK_HAS(mask, bit) ((mask)[(bit) / 64] & ((u_int64_t)1 << ((bit) % 64)))
+#define MASK_SET(mask, bit) ((mask)[(bit) / 64] |= ((u_int64_t)1 << ((bit) % 64)))
+#define MASK_CLEAR(mask, bit) ((mask)[(bit) / 64] &= ~((u_int64_t)1 << ((bit) % 64)))
+
+    git_revwalk *walk;
+    git_oid head;
+    if (git_reference_name_to_id(&head, repository, "HEAD") != 0 || git_revwalk_new(&walk, repository) != 0) {
+        corel_oidmap_free(&masks.index);
+        free(masks.masks);
+        return;
+    }
+    git_revwalk_sorting(walk, GIT_SORT_TOPOLOGICAL | GIT_SORT_TIME);
+    git_revwalk_push(walk, &head);
+    MASK_SET(corel_component_mask(&masks, &head), head_bit);
+
+    // Only an initial release needs the commits of an untagged component, --check and a missing --auto-init-tag stop at the tag
+    bool count_untagged = args.auto_init_tag && !args.check;
+    git_oid tagged[n > 0 ? n : 1];
+    size_t tagged_len = 0;
+    bool full_history = false;
+    for (size_t i = 0; i < n; i++) {
+        corel_component *component = components->entries[i];
+        git_commit *commit;
+        if (!component->tag || corel_taginfo_commit(&commit, component->tag, repository) != 0) {
+            full_history = full_history || count_untagged;
+            continue;
+        }
+        git_oid_cpy(&tagged[tagged_len++], git_commit_id(commit));
+        git_revwalk_push(walk, git_commit_id(commit));
+        MASK_SET(corel_component_mask(&masks, git_commit_id(commit)), i);
+        git_commit_free(commit);
+    }
+    git_oid common;
+    if (!full_history && tagged_len > 0 && git_merge_base_octopus(&common, repository, tagged_len, tagged) == 0) {
+        git_revwalk_hide(walk, &common);
+    }
+
+    u_int64_t walked = 0;
+    u_int64_t mask[masks.words];
+    git_oid oid;
+    while (git_revwalk_next(&oid, walk) == 0) {
+        memcpy(mask, corel_component_mask(&masks, &oid), sizeof(mask));
+        if (MASK_HAS(mask, head_bit)) {
+            walked++;
+            bool classified = false;
+            COREL_RELEASE_BUMP bump = NONE;
+            for (size_t i = 0; i < n; i++) {
+                corel_component *component = components->entries[i];
+                if (MASK_HAS(mask, i) || (!component->tag && !count_untagged) ||
+                    !corel_commit_touches(state, &oid, &component->path, component->path ? 1 : 0)) {
+                    continue;
+                }
+                if (!classified && corel_classify(state, &oid, NULL, &bump) != 0) {
+                    break;
+                }
+                classified = true;
+                component->count++;
+                if (component->tag) {
+                    component->highest = bump < component->highest ? bump : component->highest;
+                    continue;
+                }
+                if (component->count > component->bumps_capacity) {
+                    component->bumps_capacity = component->bumps_capacity ? component->bumps_capacity * 2 : 64;
+                    component->bumps = realloc(component->bumps, component->bumps_capacity);
+                }
+                component->bumps[component->count - 1] = bump;
+            }
+        }
+
+        git_oid parent;
+        for (unsigned int p = 0; corel_commit_parent(state, &oid, p, &parent) == 0; p++) {
+            u_int64_t *parent_mask = corel_component_mask(&masks, &parent);
+            bool had_head = MASK_HAS(parent_mask, head_bit);
+            for (size_t w = 0; w < masks.words; w++) {
+                parent_mask[w] |= mask[w];
+            }
+            // Released stays released through every parent, HEAD only goes down the first one with --first-parent
+            if (args.first_parent && p > 0 && !had_head) {
+                MASK_CLEAR(parent_mask, head_bit);
+            }
+        }
+    }
+    if (walked > 0) {
+        BOAST("Woaah, you have %lu commit(s)", walked);
+    }
+#undef MASK_HAS
+#undef MASK_SET
+#undef MASK_CLEAR
+    git_revwalk_free(walk);
+    corel_oidmap_free(&masks.index);
+    free(masks.masks);
+}
+
+/* --components: every version from one tag enumeration and one walk, one result per component */
+void corel_components_run(git_repository *repository, corel_cache *cache, corel_bloom *bloom) {
+    corel_component_array *components = NULL;
+    if (corel_components_parse(&components, args.components) != 0) {
+        ERROR(ERR_PARSE_ARGS)
+        BOAST_ERR("Could not read the components from %s", args.components);
+        if (components) {
+            corel_component_array_free(components);
+        }
+        return;
+    }
+    if (args.remote_tags) {
+        BOAST("--remote-tags is not supported with --components, only local tags are considered");
+    }
+    corel_components_tags(repository, components);
+
+    corel_reader *reader = NULL;
+    if (corel_reader_open(&reader, repository) != 0) {
+        BOAST_ERR("Could not open the object database");
+        corel_component_array_free(components);
+        return;
+    }
+    corel_bump_state state = {.repository = repository, .reader = reader, .cache = cache, .bloom = bloom, .highest = NONE, .stop_at = MAJOR};
+    corel_components_walk(repository, components, &state);
+    corel_reader_free(reader);
+
+    // Every release of this run lands together or not at all
+    char **tag_names = calloc(components->len, sizeof(char *));
+    size_t tag_count = 0;
+    for (size_t i = 0; i < components->len; i++) {
+        corel_component *component = components->entries[i];
+        if (component->tag) {
+            component->version = component->tag->ver;
+            corel_ver_bump(&component->version, component->highest);
+        } else if (args.check) {
+            ERROR(ERR_RELEASE_PENDING)
+            BOAST("%s: No tags have been created yet, the initial release is pending", component->name);
+            continue;
+        } else if (!args.auto_init_tag) {
+            ERROR(ERR_NO_TAGS_NO_AUTO_INIT)
+            BOAST("%s: No tags have been created yet and --auto-init-tag was not provided.", component->name);
+            continue;
+        } else {
+            corel_taginfo init;
+            if (corel_taginfo_parse(&init, args.init_version) != 0) {
+                ERROR(ERR_INVALID_INIT_TAG)
+                BOAST_ERR("Could not parse initial version %s", args.init_version);
+                break;
+            }
+            // The walk went newest first
+            component->version = init.ver;
+            for (size_t c = component->count; c > 0; c--) {
+                corel_ver_bump(&component->version, component->bumps[c - 1]);
+            }
+        }
+
+        char *version_name = corel_ver_tostr(&component->version);
+        char *tag_name = corel_tag_name_prefixed(component->tag_prefix, strlen(component->tag_prefix), &component->version);
+        BOAST("%s: %s after %lu commit(s)", component->name, tag_name, component->count);
+        if (args.print_version) {
+            printf("%s %s\n", component->name, version_name);
+        } else if (args.check) {
+            if (corel_ver_cmp(&component->version, &component->tag->ver) != 0) {
+                ERROR(ERR_RELEASE_PENDING)
+                BOAST("%s: A release is pending", component->name);
+            }
+        } else if (component->count == 0) {
+            BOAST("%s: No new commits have been made since the last tag", component->name);
+        } else if (args.dry_run) {
+            BOAST("[DRY RUN] Creating tag %s", tag_name);
+        } else {
+            BOAST("Creating tag %s", tag_name);
+            tag_names[tag_count++] = tag_name;
+            tag_name = NULL;
+        }
+        free(version_name);
+        free(tag_name);
+    }
+
+    if (tag_count > 0 && corel_tag_many(tag_names, tag_count, "HEAD", repository) == 0) {
+        BOAST("Created %lu tag(s)", tag_count);
+        if (!args.no_push) {
+            corel_push_tags(tag_names, tag_count, repository);
+        }
+        if (args.write_graph) {
+            corel_write_graph(repository);
+        }
+    }
+    for (size_t i = 0; i < tag_count; i++) {
+        free(tag_names[i]);
+    }
+    free(tag_names);
+    corel_component_array_free(components);
+}
+
+#define RETRY_BASE_DELAY_MS 200
+#define RETRY_MAX_DELAY_MS 10000
+
+/* Tags HEAD and pushes the tag. With --retry, losing the tag name to another release is not the end: the tags are read
+ * again, including the remote's when pushing, and the version is bumped from the newest one. That only walks the commits
+ * made since it. The pauses in between double each time, with jitter so racing jobs spread out.
+ * Returns whether our tag landed, latest_tag ends up with the version HEAD got released as */
+bool corel_tag_release(char **tag_name, corel_taginfo **latest_tag, git_repository *repository, corel_cache *cache, corel_bloom *bloom) {
+    unsigned int seed = getpid() ^ time(NULL) ^ (uintptr_t)tag_name;
+    for (unsigned long attempt = 0;; attempt++) {
+        int err = corel_tag_many(tag_name, 1, "HEAD", repository);
+        if (err == 0 && !args.no_push && (err = corel_push_tags(tag_name, 1, repository)) == GIT_EEXISTS) {
+            // Our tag lost the race, left behind it would look like a release of HEAD on the next try
+            git_tag_delete(repository, *tag_name);
+        }
+        if (err == 0 || (err != GIT_EEXISTS && err != GIT_ELOCKED) || attempt >= args.retries) {
+            return err == 0;
+        }
+
+        unsigned int delay = MIN(RETRY_BASE_DELAY_MS << MIN(attempt, 16), RETRY_MAX_DELAY_MS);
+        delay += rand_r(&seed) % (delay / 2 + 1);
+        BOAST("%s got taken, trying again in %u ms (%lu/%lu)", *tag_name, delay, attempt + 1, args.retries);
+        usleep(delay * 1000);
+
+        corel_taginfo *next = corel_latest_tag(repository, args.remote_tags || !args.no_push);
+
+        git_commit *since = NULL;
+        if (!next || corel_taginfo_commit(&since, next, repository) != 0) {
+            ERROR(ERR_LATEST_TAG_NOT_FOUND)
+            BOAST_ERR("Failed to lookup the commit of the new latest tag");
+            corel_taginfo_free(next);
+            return false;
+        }
+        git_oid head;
+        bool head_released = git_reference_name_to_id(&head, repository, "HEAD") == 0 && git_oid_equal(&head, git_commit_id(since));
+        corel_ver released = next->ver;
+        if (!head_released) {
+            corel_bump_version(&next->ver, repository, cache, bloom, NULL, since, false, MAJOR);
+        }
+        git_commit_free(since);
+        corel_taginfo_free(*latest_tag);
+        *latest_tag = next;
+        // Either way the other release took everything we had to release
+        if (head_released) {
+            ERROR(0)
+            BOAST("HEAD has been released as %s in the meantime", next->name);
+            return false;
+        }
+        if (corel_ver_cmp(&next->ver, &released) == 0) {
+            ERROR(0)
+            BOAST("No commits that need a release have been made since %s", next->name);
+            return false;
+        }
+        free(*tag_name);
+        *tag_name = corel_tag_name(&next->ver);
+        ERROR(0)
+    }
+}
+
+/* Everything for one repository, from the tags to the new tag */
+corel_error corel_run(const char *repo_path, corel_result *result) {
+    git_repository *repository = NULL;
+    corel_cache *cache = NULL;
+    corel_bloom *bloom = NULL;
+    corel_taginfo *latest_tag = NULL;
+    git_repository_open(&repository, repo_path);
+
+    if (!repository) {
+        ERROR(ERR_NO_REPOSITORY)
+        BOAST_ERR("%s is not a git repository", repo_path);
+        return ERR_NO_REPOSITORY;
+    }
+
+    // HEAD without a branch behind it means there is nothing to analyze
+    if (git_repository_head_unborn(repository) != 0) {
+        ERROR(ERR_NO_COMMITS)
+        BOAST_ERR("You have not made any commits yet. Why even run this?")
+        goto cleanup;
+    }
+
+    if (args.cache) {
+        cache = corel_cache_open(repository);
+    }
+    // The filters only ever answer --path questions. Runs that only look or print use the index as it is
+    if (args.changed_paths && (args.path_count > 0 || args.components)) {
+        bloom = corel_bloom_open(repository, !args.dry_run && !args.print_version);
+    }
+    if (args.components) {
+        corel_components_run(repository, cache, bloom);
+        goto cleanup;
+    }
+
+    BOAST("Grabbing tags...");
+    u_int64_t commit_count = 0;
+    COREL_RELEASE_BUMP highest = NONE;
+    git_commit *latest_tag_commit = NULL;
+    char *version_name = NULL;
+    char *tag_name = NULL;
+
+    if (args.reachable_tags) {
+        latest_tag = corel_describe_head(repository, cache, bloom, &highest, &commit_count);
+    } else {
+        latest_tag = corel_latest_tag(repository, args.remote_tags);
+    }
+
+    if (latest_tag == NULL) {
+        if (args.check) {
+            ERROR(ERR_RELEASE_PENDING)
+            BOAST("No tags have been created yet, the initial release is pending");
+            goto cleanup;
+        }
+        corel_try_auto_init(repository, cache, bloom, result);
+        goto cleanup;
+    }
+
+    BOAST("Found Latest Tag: ");
+    corel_taginfo_print(latest_tag);
+    corel_ver released = latest_tag->ver;
+
+    if (args.reachable_tags) {
+        // The describe walk already went over all commits since the nearest tags
+        corel_ver_bump(&latest_tag->ver, highest);
+    } else {
+        if (corel_taginfo_commit(&latest_tag_commit, latest_tag, repository) != 0) {
+            ERROR(ERR_LATEST_TAG_NOT_FOUND);
+            BOAST_ERR("Failed to lookup commit for the latest tag. This should not happen!");
+            goto cleanup;
+        }
+
+        BOAST_DBG("Latest Tag Refers to commit %s", git_commit_message(latest_tag_commit));
+        corel_checkpoint checkpoint;
+        if (args.incremental) {
+            corel_checkpoint_load(&checkpoint, repository);
+        }
+        commit_count = corel_bump_version(&latest_tag->ver, repository, cache, bloom, args.incremental ? &checkpoint : NULL, latest_tag_commit, false,
+                                          args.check ? PATCH : MAJOR);
+        if (args.incremental && checkpoint.valid && !args.dry_run && corel_checkpoint_save(&checkpoint, repository) != 0) {
+            BOAST_ERR("Could not save the checkpoint");
+        }
+    }
+
+    if (args.check) {
+        if (corel_ver_cmp(&latest_tag->ver, &released) != 0) {
+            ERROR(ERR_RELEASE_PENDING)
+            BOAST("A release is pending");
+        } else {
+            BOAST("No release pending");
+        }
+        goto cleanup_post_tag;
+    }
+
+    version_name = corel_ver_tostr(&latest_tag->ver);
+    tag_name = corel_tag_name(&latest_tag->ver);
+    result->version = latest_tag->ver;
+    result->has_version = true;
+    result->commits = commit_count;
+
+    if (args.print_version) {
+        if (!args.batch) {
+            printf("%s\n", version_name);
+        }
+        goto cleanup_post_tag;
+    }
+    if (commit_count == 0) {
+        BOAST("No new commits have been made since the last tag");
+        goto cleanup_post_tag;
+    }
+    if (args.dry_run) {
+        BOAST("[DRY RUN] Creating tag %s", tag_name);
+    } else {
+        result->tagged = corel_tag_release(&tag_name, &latest_tag, repository, cache, bloom);
+        result->version = latest_tag->ver;
+        if (args.write_graph) {
+            corel_write_graph(repository);
+        }
+    }
+
+cleanup_post_tag:
+    free(version_name);
+    free(tag_name);
+    git_commit_free(latest_tag_commit);
+
+cleanup:
+    corel_cache_close(cache, !args.dry_run);
+    corel_bloom_free(bloom);
+    if (repository) {
         git_repository_free(repository);
     }
     if (latest_tag) {
         corel_taginfo_free(latest_tag);
     }
+    return corel_last_error;
+}
+
+/* --batch: one task per repository. The size of its packs stands in for how long it is going to take */
+typedef struct {
+    char *path;
+    u_int64_t size;
+    corel_error error;
+} corel_batch_task;
+
+typedef struct {
+    corel_batch_task *tasks;
+    size_t len;
+    size_t next; // The next task to take, handed out with an atomic add
+} corel_batch_queue;
+
+static u_int64_t corel_repo_size(const char *path) {
+    const char *pack_dirs[] = {"/.git/objects/pack", "/objects/pack"};
+    char dir_path[PATH_MAX];
+    for (size_t i = 0; i < sizeof(pack_dirs) / sizeof(pack_dirs[0]); i++) {
+        snprintf(dir_path, sizeof(dir_path), "%s%s", path, pack_dirs[i]);
+        DIR *dir = opendir(dir_path);
+        if (!dir) {
+            continue;
+        }
+        u_int64_t size = 0;
+        struct dirent *entry;
+        struct stat st;
+        while ((entry = readdir(dir)) != NULL) {
+            size_t len = strlen(entry->d_name);
+            if (len > strlen(".pack") && strcmp(entry->d_name + len - strlen(".pack"), ".pack") == 0 &&
+                fstatat(dirfd(dir), entry->d_name, &st, 0) == 0) {
+                size += st.st_size;
+            }
+        }
+        closedir(dir);
+        return size;
+    }
+    return 0;
+}
+
+static int corel_batch_task_cmp(const void *t1, const void *t2) {
+    u_int64_t s1 = ((const corel_batch_task *)t1)->size;
+    u_int64_t s2 = ((const corel_batch_task *)t2)->size;
+    // Largest first, so the long ones do not start last and keep everyone waiting
+    return s1 < s2 ? 1 : (s1 > s2 ? -1 : 0);
+}
+
+static void corel_json_string(FILE *out, const char *str) {
+    fputc('"', out);
+    for (const unsigned char *p = (const unsigned char *)str; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            fprintf(out, "\\%c", *p);
+        } else if (*p < 0x20) {
+            fprintf(out, "\\u%04x", *p);
+        } else {
+            fputc(*p, out);
+        }
+    }
+    fputc('"', out);
+}
+
+static void corel_batch_print(corel_batch_task *task, corel_result *result) {
+    const char *status = "ok";
+    if (result->tagged) {
+        status = "released";
+    } else if (task->error == ERR_RELEASE_PENDING) {
+        status = "pending";
+    } else if (task->error != 0) {
+        status = "error";
+    }
+
+    flockfile(stdout);
+    printf("{\"repository\":");
+    corel_json_string(stdout, task->path);
+    printf(",\"status\":\"%s\",\"exit\":%d", status, task->error);
+    if (result->has_version) {
+        char *version = corel_ver_tostr(&result->version);
+        printf(",\"version\":\"%s\",\"commits\":%lu", version, result->commits);
+        free(version);
+    }
+    printf("}\n");
+    fflush(stdout);
+    funlockfile(stdout);
+}
+
+static void *corel_batch_worker(void *payload) {
+    corel_batch_queue *queue = payload;
+    size_t i;
+    while ((i = __atomic_fetch_add(&queue->next, 1, __ATOMIC_RELAXED)) < queue->len) {
+        corel_batch_task *task = &queue->tasks[i];
+        corel_result result = {0};
+        ERROR(0)
+        task->error = corel_run(task->path, &result);
+        corel_batch_print(task, &result);
+    }
+#ifdef COREL_HAVE_PCRE2
+    corel_pcre_match_free();
+#endif
+    return NULL;
+}
+
+/* Reads the repositories, starts the threads and waits for them. Each task opens its own repository, the compiled
+ * classifiers and the options are shared and only read. Exits with the highest failure of any repository, or with 80
+ * if --check found a pending release anywhere */
+corel_error corel_batch(void) {
+    FILE *list = strcmp(args.batch, "-") == 0 ? stdin : fopen(args.batch, "r");
+    if (!list) {
+        BOAST_ERR("Could not open %s", args.batch);
+        return ERR_PARSE_ARGS;
+    }
+    corel_batch_queue queue = {0};
+    size_t capacity = 0;
+    char *line = NULL;
+    size_t line_capacity = 0;
+    while (getline(&line, &line_capacity, list) >= 0) {
+        size_t len = strlen(line);
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r' || line[len - 1] == ' ')) {
+            line[--len] = '\0';
+        }
+        if (len == 0 || line[0] == '#') {
+            continue;
+        }
+        if (queue.len == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            queue.tasks = realloc(queue.tasks, capacity * sizeof(corel_batch_task));
+        }
+        queue.tasks[queue.len++] = (corel_batch_task){.path = strdup(line), .size = corel_repo_size(line)};
+    }
+    free(line);
+    if (list != stdin) {
+        fclose(list);
+    }
+    qsort(queue.tasks, queue.len, sizeof(corel_batch_task), corel_batch_task_cmp);
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t jobs = args.jobs ? args.jobs : (cpus > 0 ? cpus : 1);
+    if (!(git_libgit2_features() & GIT_FEATURE_THREADS)) {
+        BOAST_ERR("libgit2 was built without thread support, running one repository at a time");
+        jobs = 1;
+    }
+    jobs = MAX(MIN(jobs, queue.len), 1);
+
+    pthread_t *threads = malloc(jobs * sizeof(pthread_t));
+    size_t started = 0;
+    while (started < jobs && pthread_create(&threads[started], NULL, corel_batch_worker, &queue) == 0) {
+        started++;
+    }
+    if (started == 0) {
+        corel_batch_worker(&queue);
+    }
+    for (size_t i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+
+    corel_error worst = 0;
+    for (size_t i = 0; i < queue.len; i++) {
+        corel_error err = queue.tasks[i].error;
+        if (err != 0 && (worst == 0 || worst == ERR_RELEASE_PENDING || (err != ERR_RELEASE_PENDING && err > worst))) {
+            worst = err;
+        }
+        free(queue.tasks[i].path);
+    }
+    free(queue.tasks);
+    return worst;
+}
+
+int main(int argc, char *argv[]) {
+    if (corel_posix_compile() != 0) {
+        fprintf(stderr, "Error: could not compile the regexes.\n");
+        return 1;
+    }
+
+    if (corel_cli_parse_args(argc, argv, &args) != 0) {
+        printf("Could not parse args\n");
+        return ERR_PARSE_ARGS;
+    }
+
+    // POSIX stays compiled as the fallback for the other classifiers
+    if (args.classifier == CLASSIFIER_BUILTIN && corel_automaton_build() != 0) {
+        fprintf(stderr, "Error: keywords do not fit into the builtin classifier, falling back to posix.\n");
+    }
+#ifdef COREL_HAVE_PCRE2
+    if (args.classifier == CLASSIFIER_PCRE && corel_pcre_compile() != 0) {
+        fprintf(stderr, "Error: could not compile combined regex, falling back to posix.\n");
+    }
+#else
+    if (args.classifier == CLASSIFIER_PCRE) {
+        fprintf(stderr, "Error: corel was built without PCRE2, falling back to posix.\n");
+    }
+#endif
+
+    git_libgit2_init();
+    BOAST("Corel v0.0.1"); // TODO: Replace with actual version
+
+    corel_error err;
+    if (args.batch) {
+        err = corel_batch();
+    } else {
+        corel_result result = {0};
+        err = corel_run(args.repo_path, &result);
+    }
+
+    free(args.paths);
+#ifdef COREL_HAVE_PCRE2
+    corel_pcre_free();
+#endif
     git_libgit2_shutdown();
     BOAST("Bye o/");
-    return corel_last_error;
+    return err;
 }
@@ -0,0 +1,61 @@
+#include "oidmap.h"
+#include <stdlib.h>
+#include <string.h>
+
+void corel_oidmap_init(corel_oidmap *map, size_t capacity) {
+    size_t pow2 = 16;
+    while (pow2 < capacity * 2) {
+        pow2 <<= 1;
+    }
+    map->keys = malloc(pow2 * sizeof(git_oid));
+    map->values = malloc(pow2 * sizeof(u_int64_t));
+    map->used = calloc(pow2, sizeof(bool));
+    map->len = 0;
+    map->capacity = pow2;
+}
+
+void corel_oidmap_free(corel_oidmap *map) {
+    free(map->keys);
+    free(map->values);
+    free(map->used);
+}
+
+static size_t corel_oidmap_slot(corel_oidmap *map, const git_oid *oid) {
+    u_int64_t hash;
+    memcpy(&hash, oid->id, sizeof(hash));
+    size_t slot = hash & (map->capacity - 1);
+    while (map->used[slot] && memcmp(map->keys[slot].id, oid->id, GIT_OID_SHA1_SIZE) != 0) {
+        slot = (slot + 1) & (map->capacity - 1);
+    }
+    return slot;
+}
+
+u_int64_t *corel_oidmap_get(corel_oidmap *map, const git_oid *oid) {
+    size_t slot = corel_oidmap_slot(map, oid);
+    return map->used[slot] ? &map->values[slot] : NULL;
+}
+
+/* Inserts or overwrites. Returns 1 if the OID was already present */
+int corel_oidmap_put(corel_oidmap *map, const git_oid *oid, u_int64_t value) {
+    if ((map->len + 1) * 2 > map->capacity) {
+        corel_oidmap grown;
+        corel_oidmap_init(&grown, map->capacity);
+        for (size_t i = 0; i < map->capacity; i++) {
+            if (map->used[i]) {
+                corel_oidmap_put(&grown, &map->keys[i], map->values[i]);
+            }
+        }
+        corel_oidmap_free(map);
+        *map = grown;
+    }
+
+    size_t slot = corel_oidmap_slot(map, oid);
+    int existed = map->used[slot];
+    if (!existed) {
+        git_oid_cpy(&map->keys[slot], oid);
+        map->used[slot] = true;
+        map->len++;
+    }
+    map->values[slot] = value;
+    return existed;
+}
@@ -0,0 +1,24 @@
+#ifndef COREL_OIDMAP_H
+#define COREL_OIDMAP_H
+
+#include "git2/oid.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+/* Open addressing hash map from OIDs to plain values. OIDs are hashes already, so their first bytes are the hash. */
+typedef struct {
+    git_oid *keys;
+    u_int64_t *values;
+    bool *used;
+    size_t len;
+    size_t capacity;
+} corel_oidmap;
+
+void corel_oidmap_init(corel_oidmap *map, size_t capacity);
+void corel_oidmap_free(corel_oidmap *map);
+u_int64_t *corel_oidmap_get(corel_oidmap *map, const git_oid *oid);
+/* Inserts or overwrites. Returns 1 if the OID was already present */
+int corel_oidmap_put(corel_oidmap *map, const git_oid *oid, u_int64_t value);
+
+#endif
@@ -0,0 +1,97 @@
+#include "pack.h"
+#include "io.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define PACK_IDX_MAGIC "\377tOc"
+#define PACK_IDX_VERSION 2
+#define PACK_IDX_HEADER_SIZE 8
+#define PACK_IDX_FANOUT_SIZE (256 * 4)
+#define PACK_IDX_ENTRY_SIZE (GIT_OID_SHA1_SIZE + 8)    // OID, CRC and offset
+#define PACK_IDX_TRAILER_SIZE (2 * GIT_OID_SHA1_SIZE) // Checksums of the pack and the index
+
+void corel_pack_free(corel_pack *pack) {
+    munmap((void *)pack->idx, pack->idx_size);
+    if (pack->pack) {
+        munmap((void *)pack->pack, pack->pack_size);
+    }
+    free(pack->pack_path);
+    free(pack);
+}
+
+corel_pack *corel_pack_open(const char *idx_path) {
+    size_t idx_size = 0;
+    const unsigned char *idx = corel_mmap_file(idx_path, &idx_size);
+    if (!idx) {
+        return NULL;
+    }
+    if (idx_size < PACK_IDX_HEADER_SIZE + PACK_IDX_FANOUT_SIZE || memcmp(idx, PACK_IDX_MAGIC, 4) != 0 ||
+        corel_be32(idx + 4) != PACK_IDX_VERSION) {
+        munmap((void *)idx, idx_size);
+        return NULL;
+    }
+
+    // Every lookup trusts the fanout and the tables behind it, so they have to fit into the file before anything is read
+    const unsigned char *fanout = idx + PACK_IDX_HEADER_SIZE;
+    for (u_int32_t i = 1; i < 256; i++) {
+        if (corel_be32(fanout + (i - 1) * 4) > corel_be32(fanout + i * 4)) {
+            munmap((void *)idx, idx_size);
+            return NULL;
+        }
+    }
+    u_int32_t count = corel_be32(fanout + 255 * 4);
+    size_t tables = PACK_IDX_HEADER_SIZE + PACK_IDX_FANOUT_SIZE + (size_t)count * PACK_IDX_ENTRY_SIZE;
+    if (idx_size < tables + PACK_IDX_TRAILER_SIZE) {
+        munmap((void *)idx, idx_size);
+        return NULL;
+    }
+
+    corel_pack *pack = calloc(1, sizeof(corel_pack));
+    pack->idx = idx;
+    pack->idx_size = idx_size;
+    pack->count = count;
+    pack->large_count = (idx_size - tables - PACK_IDX_TRAILER_SIZE) / 8;
+    size_t stem = strlen(idx_path) - strlen("idx");
+    pack->pack_path = malloc(stem + sizeof("pack"));
+    memcpy(pack->pack_path, idx_path, stem);
+    strcpy(pack->pack_path + stem, "pack");
+    return pack;
+}
+
+const unsigned char *corel_pack_oid(corel_pack *pack, u_int32_t pos) {
+    return pack->idx + PACK_IDX_HEADER_SIZE + PACK_IDX_FANOUT_SIZE + (size_t)pos * GIT_OID_SHA1_SIZE;
+}
+
+int64_t corel_pack_find(corel_pack *pack, const git_oid *oid) {
+    const unsigned char *fanout = pack->idx + PACK_IDX_HEADER_SIZE;
+    u_int32_t lo = oid->id[0] == 0 ? 0 : corel_be32(fanout + (oid->id[0] - 1) * 4);
+    u_int32_t hi = corel_be32(fanout + oid->id[0] * 4);
+    while (lo < hi) {
+        u_int32_t mid = lo + (hi - lo) / 2;
+        int cmp = memcmp(corel_pack_oid(pack, mid), oid->id, GIT_OID_SHA1_SIZE);
+        if (cmp == 0) {
+            return mid;
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return -1;
+}
+
+u_int64_t corel_pack_offset(corel_pack *pack, u_int32_t pos) {
+    const unsigned char *crcs = corel_pack_oid(pack, pack->count);
+    const unsigned char *offsets = crcs + (size_t)pack->count * 4;
+    u_int32_t offset = corel_be32(offsets + (size_t)pos * 4);
+    if (!(offset & 0x80000000)) {
+        return offset;
+    }
+    if ((offset & 0x7fffffff) >= pack->large_count) {
+        return UINT64_MAX;
+    }
+    const unsigned char *large_offsets = offsets + (size_t)pack->count * 4;
+    return corel_be64(large_offsets + (size_t)(offset & 0x7fffffff) * 8);
+}
@@ -0,0 +1,31 @@
+#ifndef COREL_PACK_H
+#define COREL_PACK_H
+
+#include "git2/oid.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define PACK_OBJ_COMMIT 1
+
+/* A pack and its version 2 index. The index gets mapped right away, the pack itself only once an object is read */
+typedef struct {
+    const unsigned char *idx;
+    size_t idx_size;
+    const unsigned char *pack;
+    size_t pack_size;
+    u_int32_t count;
+    size_t large_count; // Entries of the table of offsets past 2 GiB
+    char *pack_path;
+} corel_pack;
+
+/* NULL unless the index is complete: a fanout that never decreases and every table it implies, up to the trailer */
+corel_pack *corel_pack_open(const char *idx_path);
+void corel_pack_free(corel_pack *pack);
+const unsigned char *corel_pack_oid(corel_pack *pack, u_int32_t pos);
+/* Binary search inside the fanout bucket of the first byte. Returns the position in the index or -1 */
+int64_t corel_pack_find(corel_pack *pack, const git_oid *oid);
+/* UINT64_MAX if the offset points past the end of the large offset table */
+u_int64_t corel_pack_offset(corel_pack *pack, u_int32_t pos);
+
+#endif
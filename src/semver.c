@@ -0,0 +1,134 @@
+#include "semver.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define IS_SEMVER_IDENT(c) (((c) >= '0' && (c) <= '9') || ((c) >= 'a' && (c) <= 'z') || ((c) >= 'A' && (c) <= 'Z') || (c) == '-')
+
+/* 0|[1-9][0-9]*, refusing anything that does not fit into 64 bits */
+static const char *corel_semver_number(const char *p, uint64_t *out, bool optional) {
+    if (*p == '0') {
+        *out = 0;
+        return p + 1;
+    }
+    if (*p < '1' || *p > '9') {
+        *out = 0;
+        return optional ? p : NULL;
+    }
+    uint64_t value = 0;
+    for (; *p >= '0' && *p <= '9'; p++) {
+        uint64_t digit = *p - '0';
+        if (value > (UINT64_MAX - digit) / 10) {
+            return NULL;
+        }
+        value = value * 10 + digit;
+    }
+    *out = value;
+    return p;
+}
+
+/* One or more dot separated, non empty identifiers */
+static const char *corel_semver_idents(const char *p) {
+    for (;;) {
+        const char *start = p;
+        while (IS_SEMVER_IDENT(*p)) {
+            p++;
+        }
+        if (p == start) {
+            return NULL;
+        }
+        if (*p != '.') {
+            return p;
+        }
+        p++;
+    }
+}
+
+int corel_taginfo_parse(corel_taginfo *out, const char *tag_name) {
+    const char *p = tag_name;
+    memset(out, 0, sizeof(corel_taginfo));
+
+    if (*p == 'v' || *p == 'V') {
+        p++;
+    }
+    if (!(p = corel_semver_number(p, &out->ver.major, false)) || *p++ != '.') {
+        return 1;
+    }
+    if (!(p = corel_semver_number(p, &out->ver.minor, false)) || *p++ != '.') {
+        return 1;
+    }
+    if (!(p = corel_semver_number(p, &out->ver.patch, true))) {
+        return 1;
+    }
+    if (*p == '-') {
+        out->prerelease = ++p;
+        if (!(p = corel_semver_idents(p))) {
+            return 1;
+        }
+        out->prerelease_len = p - out->prerelease;
+    }
+    if (*p == '+') {
+        out->build = ++p;
+        if (!(p = corel_semver_idents(p))) {
+            return 1;
+        }
+        out->build_len = p - out->build;
+    }
+    if (*p != '\0') {
+        return 1;
+    }
+
+    out->name = (char *)tag_name;
+    return 0;
+}
+
+void corel_taginfo_rebase(corel_taginfo *tag, char **buffer, size_t *capacity) {
+    size_t len = strlen(tag->name) + 1;
+    if (*capacity < len) {
+        *buffer = realloc(*buffer, len);
+        *capacity = len;
+    }
+    memcpy(*buffer, tag->name, len);
+    if (tag->prerelease) {
+        tag->prerelease = *buffer + (tag->prerelease - tag->name);
+    }
+    if (tag->build) {
+        tag->build = *buffer + (tag->build - tag->name);
+    }
+    tag->name = *buffer;
+}
+
+corel_taginfo *corel_taginfo_dup(corel_taginfo *tag) {
+    corel_taginfo *copy = malloc(sizeof(corel_taginfo));
+    *copy = *tag;
+    char *name = NULL;
+    size_t capacity = 0;
+    corel_taginfo_rebase(copy, &name, &capacity);
+    return copy;
+}
+
+int corel_then_compare(int prev, int next) {
+    if (prev == 0) {
+        return next;
+    } else {
+        return prev;
+    }
+}
+
+int corel_ver_cmp(corel_ver *v1, corel_ver *v2) {
+#define CMP(target) v1->target > v2->target ? 1 : (v1->target < v2->target ? -1 : 0)
+    int res = CMP(major);
+    res = corel_then_compare(res, CMP(minor));
+    res = corel_then_compare(res, CMP(patch));
+    return res;
+}
+
+int corel_taginfo_cmp(corel_taginfo *t1, corel_taginfo *t2) {
+    return corel_ver_cmp(&t1->ver, &t2->ver);
+}
+
+void corel_taginfo_free(corel_taginfo *tag_info) {
+    if (tag_info) {
+        free(tag_info->name);
+    }
+    free(tag_info);
+}
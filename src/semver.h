@@ -0,0 +1,40 @@
+#ifndef COREL_SEMVER_H
+#define COREL_SEMVER_H
+
+#include "git2/oid.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    uint64_t major;
+    uint64_t minor;
+    uint64_t patch;
+} corel_ver;
+
+typedef struct {
+    char *name;
+    corel_ver ver;
+    const char *prerelease; // Points into name, without the leading '-'
+    size_t prerelease_len;
+    const char *build; // Points into name, without the leading '+'
+    size_t build_len;
+    git_oid target;
+    bool peeled; // target is known to be the commit, not an annotated tag object
+    bool missing; // Only the remote has it and its commit has not been fetched
+} corel_taginfo;
+
+/* Parses v?MAJOR.MINOR.PATCH(-PRERELEASE)?(+BUILD)? in a single pass without allocating anything. The patch number may
+ * be left out (v1.2.), which is what the regex this replaces accepted as well. out->name points to tag_name.
+ * Returns 0 on success */
+int corel_taginfo_parse(corel_taginfo *out, const char *tag_name);
+/* Copies name into buffer, growing it if needed, and lets the tag refer to that copy */
+void corel_taginfo_rebase(corel_taginfo *tag, char **buffer, size_t *capacity);
+/* Heap copy that owns its name, release it with corel_taginfo_free */
+corel_taginfo *corel_taginfo_dup(corel_taginfo *tag);
+void corel_taginfo_free(corel_taginfo *tag_info);
+int corel_then_compare(int prev, int next);
+int corel_ver_cmp(corel_ver *v1, corel_ver *v2);
+int corel_taginfo_cmp(corel_taginfo *t1, corel_taginfo *t2);
+
+#endif
@@ -0,0 +1,76 @@
+#include "bitmap.h"
+#include "test.h"
+#include <stdio.h>
+#include <string.h>
+
+/* The bitmap walk against libgit2's revwalk, for the commits the bitmaps were written for and for HEAD with loose
+ * commits on top of them, with and without the reverse index of the pack */
+
+static void test_bitmap_walk(git_repository *repository) {
+    corel_pack *pack = fixture_pack(repository);
+    corel_bitmap *bitmap = pack ? corel_bitmap_open(pack) : NULL;
+    CHECK(bitmap != NULL, "no bitmap found");
+    if (!bitmap) {
+        if (pack) {
+            corel_pack_free(pack);
+        }
+        return;
+    }
+
+    const char *heads[] = {"refs/graphed", "HEAD"};
+    for (size_t h = 0; h < 2; h++) {
+        git_oid head = fixture_resolve(repository, heads[h]);
+        for (size_t r = 0; r < fixture_range_count; r++) {
+            git_commit *since = NULL;
+            git_oid since_oid;
+            git_oid resume;
+            if (fixture_ranges[r][0]) {
+                since_oid = fixture_resolve(repository, fixture_ranges[r][0]);
+                git_commit_lookup(&since, repository, &since_oid);
+            }
+            if (fixture_ranges[r][1]) {
+                resume = fixture_resolve(repository, fixture_ranges[r][1]);
+            }
+
+            oid_list expected = {0};
+            oid_list walked = {0};
+            fixture_revwalk(&expected, repository, &head, since ? &since_oid : NULL, fixture_ranges[r][1] ? &resume : NULL, false);
+            int64_t count = corel_bitmap_walk(bitmap, repository, &head, since, fixture_ranges[r][1] ? &resume : NULL, oid_list_push, &walked);
+            CHECK(count == (int64_t)walked.len, "the bitmap walk returned %ld but handed out %lu commits", count, walked.len);
+            CHECK(oid_list_same(&expected, &walked), "the bitmap walk of %s..%s (resume %s) has %lu commits, the revwalk %lu", fixture_ranges[r][0] ? fixture_ranges[r][0] : "",
+                  heads[h], fixture_ranges[r][1] ? fixture_ranges[r][1] : "-", walked.len, expected.len);
+            oid_list_clear(&expected);
+            oid_list_clear(&walked);
+            git_commit_free(since);
+        }
+    }
+    corel_bitmap_free(bitmap);
+    corel_pack_free(pack);
+}
+
+static void test_bitmap_without_rev(git_repository *repository) {
+    corel_pack *pack = fixture_pack(repository);
+    if (!pack) {
+        return;
+    }
+    size_t stem = strlen(pack->pack_path) - strlen("pack");
+    char rev[stem + sizeof("rev")];
+    char moved[stem + sizeof("rev.moved")];
+    memcpy(rev, pack->pack_path, stem);
+    strcpy(rev + stem, "rev");
+    memcpy(moved, pack->pack_path, stem);
+    strcpy(moved + stem, "rev.moved");
+    corel_pack_free(pack);
+    CHECK(rename(rev, moved) == 0, "the fixture has no reverse index");
+
+    // Without the .rev file the pack order comes from sorting the offsets
+    test_bitmap_walk(repository);
+    rename(moved, rev);
+}
+
+int main(int argc, char *argv[]) {
+    git_repository *repository = fixture_open(argc, argv);
+    test_bitmap_walk(repository);
+    test_bitmap_without_rev(repository);
+    return fixture_finish(repository, "bitmap");
+}
@@ -0,0 +1,100 @@
+#include "bloom.h"
+#include "test.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The changed-path index against libgit2's diff of every commit with its first parent, written in two goes so the
+ * second write has to merge into the first */
+
+/* Every path the commit changed against its first parent, plus the directories above them, has to be in its filter */
+static void check_bloom_paths(corel_bloom *bloom, git_repository *repository, const git_oid *oid) {
+    git_commit *commit;
+    git_commit *parent = NULL;
+    git_tree *tree;
+    git_tree *parent_tree = NULL;
+    git_diff *diff;
+    git_commit_lookup(&commit, repository, oid);
+    git_commit_tree(&tree, commit);
+    if (git_commit_parentcount(commit) > 0) {
+        git_commit_parent(&parent, commit, 0);
+        git_commit_tree(&parent_tree, parent);
+    }
+    git_diff_tree_to_tree(&diff, repository, parent_tree, tree, NULL);
+    for (size_t i = 0; i < git_diff_num_deltas(diff); i++) {
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s", git_diff_get_delta(diff, i)->new_file.path);
+        for (char *slash = path + strlen(path); slash; slash = strrchr(path, '/')) {
+            *slash = '\0';
+            CHECK(corel_bloom_query(bloom, oid, path) == 1, "the filter of %s misses %s", git_oid_tostr_s(oid), path);
+        }
+    }
+    git_diff_free(diff);
+    git_tree_free(parent_tree);
+    git_tree_free(tree);
+    git_commit_free(parent);
+    git_commit_free(commit);
+}
+
+static void test_bloom(git_repository *repository, const char *dir) {
+    git_oid head = fixture_resolve(repository, "HEAD");
+    oid_list commits = {0};
+    fixture_revwalk(&commits, repository, &head, NULL, NULL, false);
+    corel_bloom_entry *entries = calloc(commits.len, sizeof(corel_bloom_entry));
+    for (size_t i = 0; i < commits.len; i++) {
+        CHECK(corel_bloom_compute(&entries[i], repository, &commits.oids[i]) == 0, "cannot diff %s", git_oid_tostr_s(&commits.oids[i]));
+    }
+
+    // The first half goes into a fresh file, the second half gets merged into it
+    char first[PATH_MAX];
+    char merged[PATH_MAX];
+    snprintf(first, sizeof(first), "%s/changed-paths.first", dir);
+    snprintf(merged, sizeof(merged), "%s/changed-paths", dir);
+    size_t half = commits.len / 2;
+    corel_bloom bloom = {.path = first};
+    FILE *out = fopen(first, "wb");
+    CHECK(out && corel_bloom_write(&bloom, entries, half, &head, out) == 0, "cannot write %s", first);
+    if (out) {
+        fclose(out);
+    }
+    CHECK(corel_bloom_map(&bloom) == 0 && bloom.count == half, "%s has %u filters instead of %lu", first, bloom.count, half);
+
+    out = fopen(merged, "wb");
+    CHECK(out && corel_bloom_write(&bloom, entries + half, commits.len - half, &head, out) == 0, "cannot write %s", merged);
+    if (out) {
+        fclose(out);
+    }
+    corel_bloom_unmap(&bloom);
+    bloom.path = merged;
+    CHECK(corel_bloom_map(&bloom) == 0 && bloom.count == commits.len, "%s has %u filters instead of %lu", merged, bloom.count, commits.len);
+    CHECK(memcmp(bloom.map + 16, head.id, GIT_OID_SHA1_SIZE) == 0, "%s does not remember HEAD", merged);
+
+    for (size_t i = 0; i < commits.len; i++) {
+        CHECK(corel_bloom_find(&bloom, &commits.oids[i]) >= 0, "%s has no filter", git_oid_tostr_s(&commits.oids[i]));
+        check_bloom_paths(&bloom, repository, &commits.oids[i]);
+    }
+    git_oid missing;
+    git_oid_fromstr(&missing, "0123456789abcdef0123456789abcdef01234567");
+    CHECK(corel_bloom_query(&bloom, &missing, "src") == -1, "a commit without a filter got an answer");
+    corel_bloom_unmap(&bloom);
+
+    // Anything that is not an index is dropped instead of trusted
+    out = fopen(merged, "r+b");
+    if (out) {
+        fwrite("XXXX", 1, 4, out);
+        fclose(out);
+    }
+    CHECK(corel_bloom_map(&bloom) == 1 && bloom.count == 0, "a broken index got mapped");
+
+    for (size_t i = 0; i < commits.len; i++) {
+        free(entries[i].filter);
+    }
+    free(entries);
+    oid_list_clear(&commits);
+}
+
+int main(int argc, char *argv[]) {
+    git_repository *repository = fixture_open(argc, argv);
+    test_bloom(repository, argv[2]);
+    return fixture_finish(repository, "bloom");
+}
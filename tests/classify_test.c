@@ -0,0 +1,84 @@
+#include "classify.h"
+#include "test.h"
+
+/* The builtin, PCRE2 and POSIX classifiers are three implementations of the same rules, every message has to come out
+ * the same with each of them */
+
+typedef struct {
+    const char *message;
+    COREL_RELEASE_BUMP expected;
+} classify_case;
+
+static const classify_case cases[] = {
+    {"BREAKING CHANGE: drop v1", MAJOR},
+    {"breaking change: drop v1", MAJOR},
+    {"BREAKING CHANGE(api): drop v1", MAJOR},
+    {"feat: a", MINOR},
+    {"FEAT: a", MINOR},
+    {"refactor: a", MINOR},
+    {"fix: a", PATCH},
+    {"revert: a", PATCH},
+    {"ci: a", PATCH},
+    {"chore: a", PATCH},
+    // Unknown keywords and prefixes of keywords count as a patch as well
+    {"re: a", PATCH},
+    {"ref: a", PATCH},
+    {"feature: a", PATCH},
+    {"featx: a", PATCH},
+    {"BREAKING: a", PATCH},
+    {"update readme", PATCH},
+    {"", PATCH},
+    // Scopes and the optional spaces around them
+    {"feat(parser): a", MINOR},
+    {"feat (parser) : a", MINOR},
+    {"feat :a", MINOR},
+    {"feat  : a", MINOR},
+    {"feat   : a", PATCH},
+    {"feat(): a", PATCH},
+    {"feat(a)(b): c", MINOR},
+    {"feat(a) b: c", PATCH},
+    {"feat(a: b", PATCH},
+    {"feat(a\nb): c", MINOR},
+    // The subject has to have something after the colon, a newline is enough
+    {"feat:", PATCH},
+    {"feat: ", MINOR},
+    {"feat:\n\nbody", MINOR},
+    {"feat(a):", PATCH},
+    // Only the start of the message counts
+    {" feat: a", PATCH},
+    {"fix: a\n\nBREAKING CHANGE: b", PATCH},
+    {"docs: a\nfeat: b", PATCH},
+    // The keyword at the start decides, never one that comes later: MAJOR > MINOR > PATCH only between rules that match
+    {"BREAKING CHANGE: feat: a", MAJOR},
+    {"feat: BREAKING CHANGE: a", MINOR},
+    {"fix(feat): a", PATCH},
+    {"feat(BREAKING CHANGE): a", MINOR},
+    {"fix: feat: a", PATCH},
+};
+
+static const char *bump_names[] = {"MAJOR", "MINOR", "PATCH", "NONE"};
+
+int main(void) {
+    const char *classifier_names[] = {"builtin", "posix", "pcre"};
+    CHECK(corel_posix_compile() == 0, "cannot compile the POSIX regexes");
+    CHECK(corel_automaton_build() == 0, "cannot build the builtin classifier");
+#ifdef COREL_HAVE_PCRE2
+    CHECK(corel_pcre_compile() == 0, "cannot compile the PCRE2 regex");
+    corel_classifier last = CLASSIFIER_PCRE;
+#else
+    corel_classifier last = CLASSIFIER_POSIX;
+#endif
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        for (corel_classifier classifier = CLASSIFIER_BUILTIN; classifier <= last; classifier++) {
+            COREL_RELEASE_BUMP bump = corel_classifier_analyze(classifier, cases[i].message);
+            CHECK(bump == cases[i].expected, "the %s classifier makes %s of \"%s\" instead of %s", classifier_names[classifier], bump_names[bump],
+                  cases[i].message, bump_names[cases[i].expected]);
+        }
+    }
+
+#ifdef COREL_HAVE_PCRE2
+    corel_pcre_free();
+#endif
+    return test_report("classify");
+}
@@ -0,0 +1,41 @@
+#!/bin/sh
+# --reachable-tags on the reader fixture, checked out at branches that forked before the nearest tag, merged one in, or
+# sit on an octopus. Runs once on top of the commit-graph and once without it, when the commit dates order the walk.
+set -e
+
+corel="$1"
+dir="$2"
+sh "$(dirname "$0")/make_fixture.sh" "$dir/fixture" >/dev/null
+cd "$dir/fixture"
+failures=0
+
+check() {
+    git checkout -q --detach "$1"
+    got=$("$corel" -q --print-version --reachable-tags $3 --repository-path .)
+    if [ "$got" != "$2" ]; then
+        echo "FAIL: $1 $3 gave $got instead of $2" >&2
+        failures=$((failures + 1))
+    fi
+}
+
+for graph in yes no; do
+    if [ "$graph" = no ]; then
+        rm -f .git/objects/info/commit-graph
+    fi
+    check main v2.0.0
+    check refs/graphed v2.0.0
+    check v1.1.0 v1.1.0
+    check feature v1.1.0
+    check left v1.1.1
+    check right v1.0.1
+    check sync v1.2.0
+    check sync v1.0.1 --first-parent
+    check 'v1.2.0~7' v1.2.0
+    check 'v1.2.0~7' v1.1.1 --first-parent
+done
+
+if [ "$failures" -ne 0 ]; then
+    echo "$failures check(s) failed" >&2
+    exit 1
+fi
+echo "All describe checks passed"
@@ -0,0 +1,102 @@
+#include "graph.h"
+#include "test.h"
+
+/* The commit-graph reader and the walk on top of it against libgit2's revwalk of the same commits. refs/graphed is what
+ * the graph was written for, HEAD has loose commits on top of it */
+
+static void test_graph(git_repository *repository, corel_graph *graph) {
+    git_oid graphed = fixture_resolve(repository, "refs/graphed");
+    oid_list reachable = {0};
+    fixture_revwalk(&reachable, repository, &graphed, NULL, NULL, false);
+    CHECK(graph->count == reachable.len, "the graph has %u commits, %lu are reachable", graph->count, reachable.len);
+    oid_list_clear(&reachable);
+
+    bool octopus = false;
+    for (u_int32_t pos = 0; pos < graph->count; pos++) {
+        git_oid oid;
+        git_commit *commit;
+        git_oid_fromraw(&oid, corel_graph_oid(graph, pos));
+        CHECK(corel_graph_find(graph, &oid) == pos, "%s is not found at its own position %u", git_oid_tostr_s(&oid), pos);
+        if (git_commit_lookup(&commit, repository, &oid) != 0) {
+            CHECK(false, "%s from the graph is no commit", git_oid_tostr_s(&oid));
+            continue;
+        }
+
+        git_oid tree;
+        git_oid_fromraw(&tree, graph->commits + (size_t)pos * GRAPH_CDAT_SIZE);
+        CHECK(git_oid_equal(&tree, git_commit_tree_id(commit)), "%s has the wrong tree", git_oid_tostr_s(&oid));
+
+        u_int32_t n = 0;
+        u_int32_t parent;
+        for (; corel_graph_parent(graph, pos, n, &parent) == 0; n++) {
+            git_oid parent_oid;
+            git_oid_fromraw(&parent_oid, corel_graph_oid(graph, parent));
+            CHECK(n < git_commit_parentcount(commit) && git_oid_equal(&parent_oid, git_commit_parent_id(commit, n)), "parent %u of %s is wrong", n,
+                  git_oid_tostr_s(&oid));
+        }
+        CHECK(n == git_commit_parentcount(commit), "%s has %u parents in the graph, %u in the commit", git_oid_tostr_s(&oid), n,
+              git_commit_parentcount(commit));
+        octopus |= n > 2;
+        git_commit_free(commit);
+    }
+    CHECK(octopus, "the fixture has no octopus merge in the graph");
+}
+
+static int count_cb(const git_oid *oid, void *payload) {
+    (void)oid;
+    (*(size_t *)payload)++;
+    return 0;
+}
+
+static void test_graph_walk(git_repository *repository, corel_graph *graph) {
+    git_oid graphed = fixture_resolve(repository, "refs/graphed");
+    for (size_t r = 0; r < fixture_range_count; r++) {
+        for (int first_parent = 0; first_parent < 2; first_parent++) {
+            git_commit *since = NULL;
+            git_oid since_oid;
+            git_oid resume;
+            if (fixture_ranges[r][0]) {
+                since_oid = fixture_resolve(repository, fixture_ranges[r][0]);
+                git_commit_lookup(&since, repository, &since_oid);
+            }
+            if (fixture_ranges[r][1]) {
+                resume = fixture_resolve(repository, fixture_ranges[r][1]);
+            }
+
+            oid_list expected = {0};
+            oid_list walked = {0};
+            fixture_revwalk(&expected, repository, &graphed, since ? &since_oid : NULL, fixture_ranges[r][1] ? &resume : NULL, first_parent);
+            int64_t count = corel_graph_walk(graph, &graphed, since, fixture_ranges[r][1] ? &resume : NULL, first_parent, oid_list_push, &walked);
+            CHECK(count == (int64_t)walked.len, "the graph walk returned %ld but handed out %lu commits", count, walked.len);
+            CHECK(oid_list_same(&expected, &walked), "the graph walk of %s..graphed (resume %s, first parent %d) has %lu commits, the revwalk %lu",
+                  fixture_ranges[r][0] ? fixture_ranges[r][0] : "", fixture_ranges[r][1] ? fixture_ranges[r][1] : "-", first_parent, walked.len, expected.len);
+            oid_list_clear(&expected);
+            oid_list_clear(&walked);
+            git_commit_free(since);
+        }
+    }
+
+    // HEAD has commits the graph does not know about, that is for the caller to walk the slow way
+    git_oid head = fixture_resolve(repository, "HEAD");
+    git_commit *since;
+    git_oid since_oid = fixture_resolve(repository, "v1.2.0");
+    git_commit_lookup(&since, repository, &since_oid);
+    size_t called = 0;
+    CHECK(corel_graph_walk(graph, &head, since, NULL, false, count_cb, &called) == -1 && called == 0, "the graph walk did not refuse a HEAD it does not know");
+    git_commit_free(since);
+}
+
+int main(int argc, char *argv[]) {
+    git_repository *repository = fixture_open(argc, argv);
+    git_buf objects_dir = {0};
+    git_repository_item_path(&objects_dir, repository, GIT_REPOSITORY_ITEM_OBJECTS);
+    corel_graph *graph = corel_graph_open(objects_dir.ptr);
+    CHECK(graph != NULL, "cannot read the commit-graph");
+    if (graph) {
+        test_graph(repository, graph);
+        test_graph_walk(repository, graph);
+        corel_graph_free(graph);
+    }
+    git_buf_dispose(&objects_dir);
+    return fixture_finish(repository, "graph");
+}
@@ -0,0 +1,66 @@
+#!/bin/sh
+# Builds the repository the reader tests run against: merges, a branch main got merged into, an octopus merge,
+# lightweight and annotated tags, one pack with bitmaps, a reverse index and a commit-graph, and then commits on top
+# that are left loose.
+set -e
+
+dir="$1"
+rm -rf "$dir"
+git init -q -b main "$dir"
+cd "$dir"
+git config user.name corel
+git config user.email corel@example.com
+git config gc.auto 0
+
+n=0
+commit() {
+    n=$((n + 1))
+    mkdir -p "$(dirname "$1")"
+    echo "$n" >"$1"
+    git add "$1"
+    GIT_COMMITTER_DATE="$((1700000000 + n)) +0000" GIT_AUTHOR_DATE="$((1700000000 + n)) +0000" git commit -q -m "$2"
+}
+merge() {
+    message="$1"
+    shift
+    GIT_COMMITTER_DATE="$((1700000000 + n)) +0000" GIT_AUTHOR_DATE="$((1700000000 + n)) +0000" git merge -q --no-ff -m "$message" "$@" >/dev/null
+}
+
+commit README "chore: init"
+git tag v1.0.0
+commit src/a.c "feat: a"
+git checkout -q -b feature
+commit src/feature/x.c "feat: x"
+commit docs/x.md "docs: x"
+git checkout -q main
+commit src/a.c "fix: a"
+git tag -a v1.1.0 -m "v1.1.0"
+merge "Merge feature" feature
+git checkout -q -b sync v1.0.0
+commit sync/s.c "fix: sync"
+merge "Merge main into sync" main
+git checkout -q main
+git checkout -q -b left v1.1.0
+commit left/l.c "fix: left"
+git checkout -q -b right v1.0.0
+commit right/r.c "fix: right"
+git checkout -q -b up v1.1.0
+commit up/u.c "fix: up"
+git checkout -q main
+merge "Merge left, right and up" left right up
+merge "Merge sync" sync
+for i in 1 2 3 4 5 6; do
+    commit "src/dir$((i % 3))/file$i.c" "fix: file $i"
+done
+git tag v1.2.0
+commit src/b.c "BREAKING CHANGE: b"
+
+git -c pack.writeReverseIndex=true repack -adq --write-bitmap-index
+git commit-graph write --reachable --no-progress
+git update-ref refs/graphed HEAD
+
+git checkout -q -b late
+commit late/l.c "feat: late"
+git checkout -q main
+commit src/c.c "fix: c"
+merge "Merge late" late
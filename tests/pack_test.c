@@ -0,0 +1,129 @@
+#include "io.h"
+#include "pack.h"
+#include "test.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The pack index reader against what libgit2 makes of the same pack */
+
+static int offset_cmp(const void *o1, const void *o2) {
+    const u_int64_t *offset1 = o1;
+    const u_int64_t *offset2 = o2;
+    return (*offset1 > *offset2) - (*offset1 < *offset2);
+}
+
+static void test_pack(git_repository *repository) {
+    corel_pack *pack = fixture_pack(repository);
+    CHECK(pack != NULL, "no pack found");
+    if (!pack) {
+        return;
+    }
+    pack->pack = corel_mmap_file(pack->pack_path, &pack->pack_size);
+    CHECK(pack->pack != NULL, "cannot map %s", pack->pack_path);
+
+    git_odb *odb;
+    git_repository_odb(&odb, repository);
+    u_int64_t *offsets = malloc(pack->count * sizeof(u_int64_t));
+    for (u_int32_t pos = 0; pos < pack->count; pos++) {
+        git_oid oid;
+        git_oid_fromraw(&oid, corel_pack_oid(pack, pos));
+        CHECK(corel_pack_find(pack, &oid) == pos, "%s is not found at its own position %u", git_oid_tostr_s(&oid), pos);
+        offsets[pos] = corel_pack_offset(pack, pos);
+        CHECK(offsets[pos] >= 12 && offsets[pos] < pack->pack_size, "offset of %s is outside the pack", git_oid_tostr_s(&oid));
+
+        // Whole objects say their type right at the offset, deltas (6, 7) are git's business
+        size_t size;
+        git_object_t type;
+        CHECK(git_odb_read_header(&size, &type, odb, &oid) == 0, "%s is not in the odb", git_oid_tostr_s(&oid));
+        int packed_type = (pack->pack[offsets[pos]] >> 4) & 7;
+        CHECK(packed_type >= 6 || packed_type == (int)type, "%s has type %d in the pack, %d in the odb", git_oid_tostr_s(&oid), packed_type, type);
+    }
+    qsort(offsets, pack->count, sizeof(u_int64_t), offset_cmp);
+    for (u_int32_t i = 1; i < pack->count; i++) {
+        CHECK(offsets[i] != offsets[i - 1], "two objects share offset %lu", offsets[i]);
+    }
+
+    // The commits made after the repack are loose
+    git_oid head = fixture_resolve(repository, "HEAD");
+    git_oid packed = fixture_resolve(repository, "v1.2.0");
+    CHECK(corel_pack_find(pack, &head) == -1, "found a loose commit in the pack");
+    CHECK(corel_pack_find(pack, &packed) >= 0, "v1.2.0 is not in the pack");
+    git_oid missing;
+    git_oid_fromstr(&missing, "0123456789abcdef0123456789abcdef01234567");
+    CHECK(corel_pack_find(pack, &missing) == -1, "found an object that is not in the pack");
+
+    free(offsets);
+    git_odb_free(odb);
+    corel_pack_free(pack);
+}
+
+/* Writes len bytes of the index with one 32-bit word replaced (none for a negative word) and opens it */
+static corel_pack *open_broken(corel_pack *pack, const char *dir, size_t len, long word, u_int32_t value) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/broken.idx", dir);
+    unsigned char *data = malloc(pack->idx_size);
+    memcpy(data, pack->idx, pack->idx_size);
+    if (word >= 0) {
+        corel_put_be32(data + word * 4, value);
+    }
+    FILE *out = fopen(path, "wb");
+    if (out) {
+        fwrite(data, 1, len, out);
+        fclose(out);
+    }
+    free(data);
+    return corel_pack_open(path);
+}
+
+static void test_pack_broken(git_repository *repository, const char *dir) {
+    corel_pack *pack = fixture_pack(repository);
+    if (!pack) {
+        return;
+    }
+    size_t fanout = 2;
+    size_t offsets = (8 + 1024 + (size_t)pack->count * 24) / 4;
+
+    corel_pack *intact = open_broken(pack, dir, pack->idx_size, -1, 0);
+    CHECK(intact && intact->count == pack->count && intact->large_count == 0, "a copy of the index does not open the same");
+    if (intact) {
+        corel_pack_free(intact);
+    }
+
+    // Every table has to fit, down to the trailer
+    size_t cuts[] = {8 + 1024, 8 + 1024 + (size_t)pack->count * 20, pack->idx_size - 40, pack->idx_size - 1};
+    for (size_t i = 0; i < sizeof(cuts) / sizeof(cuts[0]); i++) {
+        corel_pack *broken = open_broken(pack, dir, cuts[i], -1, 0);
+        CHECK(broken == NULL, "an index cut to %lu of %lu bytes got opened", cuts[i], pack->idx_size);
+        if (broken) {
+            corel_pack_free(broken);
+        }
+    }
+
+    // A fanout claiming more objects than the file holds, and one that goes down again
+    corel_pack *broken = open_broken(pack, dir, pack->idx_size, fanout + 255, pack->count + 1);
+    CHECK(broken == NULL, "an index with too many objects got opened");
+    if (broken) {
+        corel_pack_free(broken);
+    }
+    broken = open_broken(pack, dir, pack->idx_size, fanout + 10, pack->count);
+    CHECK(broken == NULL || corel_be32(pack->idx + (fanout + 11) * 4) == pack->count, "an index with a decreasing fanout got opened");
+    if (broken) {
+        corel_pack_free(broken);
+    }
+
+    // An offset into the large offset table the index does not have
+    broken = open_broken(pack, dir, pack->idx_size, offsets, 0x80000000);
+    CHECK(broken && corel_pack_offset(broken, 0) == UINT64_MAX, "a large offset outside the index was read");
+    if (broken) {
+        corel_pack_free(broken);
+    }
+    corel_pack_free(pack);
+}
+
+int main(int argc, char *argv[]) {
+    git_repository *repository = fixture_open(argc, argv);
+    test_pack(repository);
+    test_pack_broken(repository, argv[2]);
+    return fixture_finish(repository, "pack");
+}
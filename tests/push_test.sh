@@ -0,0 +1,69 @@
+#!/bin/sh
+# Pushes releases to a bare remote over file:// from two clones whose main branches went separate ways: the tag goes out
+# even though main would not fast-forward, a tag the remote has at the same commit is left alone, and one it has at
+# another commit is refused with ERR_TAG_NOT_PUSHED.
+set -e
+
+corel="$1"
+dir="$2"
+rm -rf "$dir"
+mkdir -p "$dir"
+remote="file://$dir/remote.git"
+failures=0
+
+fail() {
+    echo "FAIL: $*" >&2
+    failures=$((failures + 1))
+}
+
+# Runs corel in the clone and checks its exit code
+release() {
+    clone="$1"
+    expected="$2"
+    shift 2
+    code=0
+    "$corel" -q --repository-path "$dir/$clone" "$@" >/dev/null 2>&1 || code=$?
+    if [ "$code" -ne "$expected" ]; then
+        fail "$clone exited with $code instead of $expected"
+    fi
+}
+
+remote_tag() {
+    git --git-dir "$dir/remote.git" rev-parse -q --verify "refs/tags/$1" || true
+}
+
+git init -q --bare -b main "$dir/remote.git"
+git init -q -b main "$dir/seed"
+git -C "$dir/seed" -c user.name=corel -c user.email=corel@example.com commit -q --allow-empty -m "chore: init"
+git -C "$dir/seed" tag v1.0.0
+git -C "$dir/seed" push -q "$remote" main v1.0.0
+for clone in a b; do
+    git clone -q "$remote" "$dir/$clone"
+    git -C "$dir/$clone" config user.name corel
+    git -C "$dir/$clone" config user.email corel@example.com
+done
+
+# a moves the remote's main on, b's main no longer fast-forwards but its tag does not care
+git -C "$dir/a" commit -q --allow-empty -m "fix: a"
+git -C "$dir/a" push -q origin main
+git -C "$dir/b" commit -q --allow-empty -m "fix: b"
+release b 0
+b_head=$(git -C "$dir/b" rev-parse HEAD)
+[ "$(remote_tag v1.0.1)" = "$b_head" ] || fail "the remote has v1.0.1 at '$(remote_tag v1.0.1)' instead of b's HEAD"
+[ "$(git --git-dir "$dir/remote.git" rev-parse main)" = "$(git -C "$dir/a" rev-parse HEAD)" ] || fail "the remote's main moved"
+git --git-dir "$dir/remote.git" cat-file -e "$b_head" || fail "the tagged commit did not reach the remote"
+
+# Released again at the same commit, the remote has the tag already and nothing gets pushed
+git -C "$dir/b" tag -d v1.0.1 >/dev/null
+release b 0
+[ "$(remote_tag v1.0.1)" = "$b_head" ] || fail "v1.0.1 moved on the remote"
+
+# a comes up with the same version for another commit
+release a 45
+[ "$(remote_tag v1.0.1)" = "$b_head" ] || fail "a's v1.0.1 replaced b's on the remote"
+
+if [ "$failures" -ne 0 ]; then
+    echo "$failures check(s) failed" >&2
+    exit 1
+fi
+echo "All push checks passed"
@@ -0,0 +1,66 @@
+#!/bin/sh
+# Two clones of one bare remote over file:// release at once and both come up with v1.0.1. a pushes first, b finds the
+# tag taken at another commit: without --retry it gives up with ERR_TAG_NOT_PUSHED, with --retry it reads the remote's
+# tags again and releases the next version instead. Either way b's own v1.0.1 does not stay behind.
+set -e
+
+corel="$1"
+dir="$2"
+rm -rf "$dir"
+mkdir -p "$dir"
+remote="file://$dir/remote.git"
+failures=0
+
+fail() {
+    echo "FAIL: $*" >&2
+    failures=$((failures + 1))
+}
+
+# Runs corel in the clone and checks its exit code
+release() {
+    clone="$1"
+    expected="$2"
+    shift 2
+    code=0
+    "$corel" -q --repository-path "$dir/$clone" "$@" >/dev/null 2>&1 || code=$?
+    if [ "$code" -ne "$expected" ]; then
+        fail "$clone $* exited with $code instead of $expected"
+    fi
+}
+
+tag() {
+    git --git-dir "$1" rev-parse -q --verify "refs/tags/$2" || true
+}
+
+git init -q --bare -b main "$dir/remote.git"
+git init -q -b main "$dir/seed"
+git -C "$dir/seed" -c user.name=corel -c user.email=corel@example.com commit -q --allow-empty -m "chore: init"
+git -C "$dir/seed" tag v1.0.0
+git -C "$dir/seed" push -q "$remote" main v1.0.0
+for clone in a b; do
+    git clone -q "$remote" "$dir/$clone"
+    git -C "$dir/$clone" config user.name corel
+    git -C "$dir/$clone" config user.email corel@example.com
+    git -C "$dir/$clone" commit -q --allow-empty -m "fix: $clone"
+done
+
+release a 0
+a_head=$(git -C "$dir/a" rev-parse HEAD)
+b_head=$(git -C "$dir/b" rev-parse HEAD)
+[ "$(tag "$dir/remote.git" v1.0.1)" = "$a_head" ] || fail "a did not release v1.0.1"
+
+release b 45
+[ -z "$(tag "$dir/b/.git" v1.0.1)" ] || fail "b kept the v1.0.1 it lost"
+
+# The remote's v1.0.1 is on a commit b never fetched, the commits b has since v1.0.0 bump it
+release b 0 --retry 2
+[ -z "$(tag "$dir/b/.git" v1.0.1)" ] || fail "b kept the v1.0.1 it lost with --retry"
+[ "$(tag "$dir/remote.git" v1.0.1)" = "$a_head" ] || fail "a's v1.0.1 moved"
+[ "$(tag "$dir/remote.git" v1.0.2)" = "$b_head" ] || fail "b did not release v1.0.2"
+[ "$(tag "$dir/b/.git" v1.0.2)" = "$b_head" ] || fail "b has no v1.0.2 of its own"
+
+if [ "$failures" -ne 0 ]; then
+    echo "$failures check(s) failed" >&2
+    exit 1
+fi
+echo "All race checks passed"
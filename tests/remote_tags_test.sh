@@ -0,0 +1,66 @@
+#!/bin/sh
+# --remote-tags against a bare remote over file:// that gets tags the clone never fetches: an annotated one, whose
+# commit only shows up as the name^{} entry of the advertisement, one on a commit that only the remote has, and ones
+# --tag-pattern has to keep out.
+set -e
+
+corel="$1"
+dir="$2"
+rm -rf "$dir"
+mkdir -p "$dir"
+remote="file://$dir/remote.git"
+failures=0
+
+check() {
+    expected="$1"
+    shift
+    got=$("$corel" -q --print-version --repository-path "$dir/local" "$@")
+    if [ "$got" != "$expected" ]; then
+        echo "FAIL: $* gave $got instead of $expected" >&2
+        failures=$((failures + 1))
+    fi
+}
+
+git init -q --bare -b main "$dir/remote.git"
+git init -q -b main "$dir/seed"
+git -C "$dir/seed" config user.name corel
+git -C "$dir/seed" config user.email corel@example.com
+git -C "$dir/seed" commit -q --allow-empty -m "chore: init"
+git -C "$dir/seed" tag v1.0.0
+git -C "$dir/seed" commit -q --allow-empty -m "fix: one"
+git -C "$dir/seed" push -q "$remote" main v1.0.0
+git clone -q "$remote" "$dir/local"
+git -C "$dir/local" config user.name corel
+git -C "$dir/local" config user.email corel@example.com
+
+# Peeled through ^{} the tag is at HEAD, taken as the tag object it would be a tag we do not have
+git -C "$dir/seed" tag -a -m "Release v1.1.0" v1.1.0
+git -C "$dir/seed" push -q "$remote" v1.1.0
+check v1.0.1
+check v1.1.0 --remote-tags
+
+# The commit of v1.2.0 never gets fetched, the commits since v1.1.0 bump it
+git -C "$dir/seed" commit -q --allow-empty -m "feat: two"
+git -C "$dir/seed" tag v1.2.0
+git -C "$dir/seed" push -q "$remote" v1.2.0
+git -C "$dir/local" commit -q --allow-empty -m "fix: local"
+check v1.0.1
+check v1.2.1 --remote-tags
+git -C "$dir/local" cat-file -e "$(git -C "$dir/seed" rev-parse v1.2.0)" 2>/dev/null && {
+    echo "FAIL: the commit of v1.2.0 got fetched" >&2
+    failures=$((failures + 1))
+}
+
+# Tags outside the pattern are left out no matter which side has them
+git -C "$dir/seed" tag v3.0.0 HEAD~1
+git -C "$dir/seed" tag billing/v5.0.0 HEAD~1
+git -C "$dir/seed" push -q "$remote" v3.0.0 billing/v5.0.0
+check v3.0.1 --remote-tags
+check v1.2.1 --remote-tags --tag-pattern 'v1.*'
+check v5.0.1 --remote-tags --tag-pattern 'billing/v*'
+
+if [ "$failures" -ne 0 ]; then
+    echo "$failures check(s) failed" >&2
+    exit 1
+fi
+echo "All remote tag checks passed"
@@ -0,0 +1,114 @@
+#include "semver.h"
+#include "test.h"
+#include <string.h>
+
+/* corel_taginfo_parse on the tag names it has to take apart and the ones it has to refuse */
+
+typedef struct {
+    const char *name;
+    bool valid;
+    corel_ver ver;
+    const char *prerelease;
+    const char *build;
+} semver_case;
+
+static const semver_case cases[] = {
+    {"v1.2.3", true, {1, 2, 3}, NULL, NULL},
+    {"V1.2.3", true, {1, 2, 3}, NULL, NULL},
+    {"1.2.3", true, {1, 2, 3}, NULL, NULL},
+    {"v0.0.0", true, {0, 0, 0}, NULL, NULL},
+    {"vv1.2.3", false},
+    {"x1.2.3", false},
+    {"v1.2", false},
+    {"v1", false},
+    {"", false},
+    {"v1.2.3 ", false},
+    // Leading zeros
+    {"v01.2.3", false},
+    {"v1.02.3", false},
+    {"v1.2.03", false},
+    {"v10.20.30", true, {10, 20, 30}, NULL, NULL},
+    // 2^64 - 1 is the largest version number there is
+    {"v18446744073709551615.18446744073709551615.18446744073709551615", true, {UINT64_MAX, UINT64_MAX, UINT64_MAX}, NULL, NULL},
+    {"v18446744073709551616.0.0", false},
+    {"v0.18446744073709551616.0", false},
+    {"v0.0.18446744073709551616", false},
+    {"v99999999999999999999999.0.0", false},
+    // The patch number may be left out
+    {"v1.2.", true, {1, 2, 0}, NULL, NULL},
+    {"v1.2.-rc", true, {1, 2, 0}, "rc", NULL},
+    {"v1.2.+b", true, {1, 2, 0}, NULL, "b"},
+    // Pre-release and build
+    {"v1.2.3-rc", true, {1, 2, 3}, "rc", NULL},
+    {"v1.2.3-rc.1", true, {1, 2, 3}, "rc.1", NULL},
+    {"v1.2.3-alpha-2.x", true, {1, 2, 3}, "alpha-2.x", NULL},
+    {"v1.2.3+build.5", true, {1, 2, 3}, NULL, "build.5"},
+    {"v1.2.3-rc.1+build.5", true, {1, 2, 3}, "rc.1", "build.5"},
+    {"v1.2.3-", false},
+    {"v1.2.3-rc.", false},
+    {"v1.2.3-rc..1", false},
+    {"v1.2.3-rc_1", false},
+    {"v1.2.3+", false},
+    {"v1.2.3+b+c", false},
+    {"v1.2.3+b-rc", true, {1, 2, 3}, NULL, "b-rc"},
+};
+
+static void check_part(const char *name, const char *what, const char *got, size_t got_len, const char *expected) {
+    if (!expected) {
+        CHECK(got == NULL && got_len == 0, "%s has a %s of %.*s", name, what, (int)got_len, got ? got : "");
+        return;
+    }
+    CHECK(got && got_len == strlen(expected) && strncmp(got, expected, got_len) == 0, "%s has the %s %.*s instead of %s", name, what, (int)got_len,
+          got ? got : "", expected);
+}
+
+static void test_parse(void) {
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        const semver_case *c = &cases[i];
+        corel_taginfo tag;
+        int err = corel_taginfo_parse(&tag, c->name);
+        CHECK((err == 0) == c->valid, "%s was %s", c->name, err == 0 ? "accepted" : "refused");
+        if (err != 0 || !c->valid) {
+            continue;
+        }
+        CHECK(tag.name == c->name, "%s does not point to the name it was parsed from", c->name);
+        CHECK(corel_ver_cmp(&tag.ver, (corel_ver *)&c->ver) == 0, "%s was parsed as %lu.%lu.%lu", c->name, tag.ver.major, tag.ver.minor, tag.ver.patch);
+        check_part(c->name, "pre-release", tag.prerelease, tag.prerelease_len, c->prerelease);
+        check_part(c->name, "build", tag.build, tag.build_len, c->build);
+    }
+}
+
+/* The copies own their name, and the pre-release and build have to move along with it */
+static void test_dup(void) {
+    const char name[] = "v1.2.3-rc.1+build.5";
+    corel_taginfo tag;
+    corel_taginfo_parse(&tag, name);
+    corel_taginfo *copy = corel_taginfo_dup(&tag);
+    CHECK(copy->name != name && strcmp(copy->name, name) == 0, "the copy does not own its name");
+    check_part("the copy", "pre-release", copy->prerelease, copy->prerelease_len, "rc.1");
+    check_part("the copy", "build", copy->build, copy->build_len, "build.5");
+    CHECK(copy->prerelease == copy->name + 7 && copy->build == copy->name + 12, "the copy still points into the original");
+    corel_taginfo_free(copy);
+}
+
+static void test_cmp(void) {
+    const char *ordered[] = {"v0.0.1", "v0.1.0", "v0.1.1", "v1.0.0", "v1.0.10", "v1.9.0", "v1.10.0", "v2.0.0"};
+    size_t len = sizeof(ordered) / sizeof(ordered[0]);
+    for (size_t i = 0; i < len; i++) {
+        for (size_t j = 0; j < len; j++) {
+            corel_taginfo a;
+            corel_taginfo b;
+            corel_taginfo_parse(&a, ordered[i]);
+            corel_taginfo_parse(&b, ordered[j]);
+            int expected = i < j ? -1 : (i > j ? 1 : 0);
+            CHECK(corel_taginfo_cmp(&a, &b) == expected, "%s compared to %s is %d", ordered[i], ordered[j], corel_taginfo_cmp(&a, &b));
+        }
+    }
+}
+
+int main(void) {
+    test_parse();
+    test_dup();
+    test_cmp();
+    return test_report("semver");
+}
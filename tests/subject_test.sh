@@ -0,0 +1,47 @@
+#!/bin/sh
+# Pins down what the subject window (COREL_SUBJECT_LINES, COREL_SUBJECT_MAX) lets the classification see: one commit
+# on top of v1.0.0 per case, and the version corel prints for it.
+set -e
+
+corel="$1"
+dir="$2"
+rm -rf "$dir"
+mkdir -p "$dir"
+long=$(printf '%01100d' 0)
+failures=0
+
+check() {
+    message="$1"
+    expected="$2"
+    repo="$dir/repo"
+    rm -rf "$repo"
+    git init -q -b main "$repo"
+    git -C "$repo" config user.name corel
+    git -C "$repo" config user.email corel@example.com
+    git -C "$repo" commit -q --allow-empty -m "chore: init"
+    git -C "$repo" tag v1.0.0
+    printf '%b' "$message" | git -C "$repo" commit -q --allow-empty --cleanup=verbatim -F -
+    got=$("$corel" -q --print-version --repository-path "$repo")
+    if [ "$got" != "$expected" ]; then
+        echo "FAIL: '$message' gave $got instead of $expected" >&2
+        failures=$((failures + 1))
+    fi
+}
+
+check 'feat: a\n' v1.1.0
+check 'feat:\n\nbody\n' v1.1.0
+check "feat: $long\n" v1.1.0
+# A scope may span the first two lines, one that closes on the third or later is not seen
+check 'feat(a\nb): c\n' v1.1.0
+check 'feat(a\nb\nc): d\n' v1.0.1
+check 'feat(a\n\n): b\n' v1.0.1
+# Neither is one that runs past COREL_SUBJECT_MAX
+check "feat($long): b\n" v1.0.1
+# Footers never counted, ^ only anchors at the start of the message
+check 'fix: a\n\nBREAKING CHANGE: b\n' v1.0.1
+
+if [ "$failures" -ne 0 ]; then
+    echo "$failures check(s) failed" >&2
+    exit 1
+fi
+echo "All subject checks passed"
@@ -0,0 +1,141 @@
+#include "test.h"
+#include <dirent.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+int failures = 0;
+
+const char *fixture_ranges[][2] = {
+    {NULL, NULL}, {"v1.0.0", NULL}, {"v1.1.0", NULL}, {"v1.2.0", NULL}, {"feature", NULL}, {"right", NULL}, {"sync", NULL}, {"v1.0.0", "left"}, {"v1.1.0", "v1.2.0"},
+};
+const size_t fixture_range_count = sizeof(fixture_ranges) / sizeof(fixture_ranges[0]);
+
+int oid_list_push(const git_oid *oid, void *payload) {
+    oid_list *list = payload;
+    if (list->len == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 64;
+        list->oids = realloc(list->oids, list->capacity * sizeof(git_oid));
+    }
+    git_oid_cpy(&list->oids[list->len++], oid);
+    return 0;
+}
+
+static int oid_list_cmp(const void *o1, const void *o2) {
+    return git_oid_cmp(o1, o2);
+}
+
+bool oid_list_same(oid_list *a, oid_list *b) {
+    qsort(a->oids, a->len, sizeof(git_oid), oid_list_cmp);
+    qsort(b->oids, b->len, sizeof(git_oid), oid_list_cmp);
+    if (a->len != b->len) {
+        return false;
+    }
+    for (size_t i = 0; i < a->len; i++) {
+        if (!git_oid_equal(&a->oids[i], &b->oids[i]) || (i > 0 && git_oid_equal(&a->oids[i], &a->oids[i - 1]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void oid_list_clear(oid_list *list) {
+    free(list->oids);
+    list->oids = NULL;
+    list->len = 0;
+    list->capacity = 0;
+}
+
+git_repository *fixture_open(int argc, char *argv[]) {
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <make_fixture.sh> <scratch dir>\n", argv[0]);
+        exit(2);
+    }
+    char repo_dir[PATH_MAX];
+    char command[2 * PATH_MAX + 16];
+    snprintf(repo_dir, sizeof(repo_dir), "%s/fixture", argv[2]);
+    snprintf(command, sizeof(command), "sh '%s' '%s'", argv[1], repo_dir);
+    if (system(command) != 0) {
+        fprintf(stderr, "Could not create the fixture\n");
+        exit(2);
+    }
+
+    git_libgit2_init();
+    git_repository *repository;
+    if (git_repository_open(&repository, repo_dir) != 0) {
+        fprintf(stderr, "Could not open %s\n", repo_dir);
+        exit(2);
+    }
+    return repository;
+}
+
+int test_report(const char *name) {
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("All %s checks passed\n", name);
+    return 0;
+}
+
+int fixture_finish(git_repository *repository, const char *name) {
+    git_repository_free(repository);
+    git_libgit2_shutdown();
+    return test_report(name);
+}
+
+git_oid fixture_resolve(git_repository *repository, const char *spec) {
+    git_object *object;
+    char peeled[256];
+    snprintf(peeled, sizeof(peeled), "%s^{commit}", spec);
+    git_oid oid = {{0}};
+    if (git_revparse_single(&object, repository, peeled) != 0) {
+        fprintf(stderr, "Cannot resolve %s\n", spec);
+        exit(2);
+    }
+    git_oid_cpy(&oid, git_object_id(object));
+    git_object_free(object);
+    return oid;
+}
+
+void fixture_revwalk(oid_list *out, git_repository *repository, const git_oid *head, const git_oid *since, const git_oid *resume, bool first_parent) {
+    git_revwalk *walk;
+    git_revwalk_new(&walk, repository);
+    if (first_parent) {
+        git_revwalk_simplify_first_parent(walk);
+    }
+    git_revwalk_push(walk, head);
+    if (since) {
+        git_revwalk_hide(walk, since);
+    }
+    if (resume) {
+        git_revwalk_hide(walk, resume);
+    }
+    git_oid oid;
+    while (git_revwalk_next(&oid, walk) == 0) {
+        oid_list_push(&oid, out);
+    }
+    git_revwalk_free(walk);
+}
+
+corel_pack *fixture_pack(git_repository *repository) {
+    git_buf objects_dir = {0};
+    char path[PATH_MAX];
+    git_repository_item_path(&objects_dir, repository, GIT_REPOSITORY_ITEM_OBJECTS);
+    snprintf(path, sizeof(path), "%spack", objects_dir.ptr);
+    DIR *dir = opendir(path);
+    corel_pack *pack = NULL;
+    struct dirent *entry;
+    while (dir && !pack && (entry = readdir(dir)) != NULL) {
+        size_t len = strlen(entry->d_name);
+        if (len > 4 && strcmp(entry->d_name + len - 4, ".idx") == 0) {
+            snprintf(path, sizeof(path), "%spack/%s", objects_dir.ptr, entry->d_name);
+            pack = corel_pack_open(path);
+        }
+    }
+    if (dir) {
+        closedir(dir);
+    }
+    git_buf_dispose(&objects_dir);
+    return pack;
+}
@@ -0,0 +1,53 @@
+#ifndef COREL_TEST_H
+#define COREL_TEST_H
+
+#include "pack.h"
+#include <git2.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/* What the tests of the readers share: a check that counts failures instead of stopping at the first one, and the
+ * repository make_fixture.sh builds, see there for what it has in it */
+
+extern int failures;
+
+#define CHECK(cond, ...)                                                                                                                                       \
+    if (!(cond)) {                                                                                                                                             \
+        failures++;                                                                                                                                            \
+        fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__);                                                                                                   \
+        fprintf(stderr, __VA_ARGS__);                                                                                                                          \
+        fprintf(stderr, "\n");                                                                                                                                 \
+    }
+
+typedef struct {
+    git_oid *oids;
+    size_t len;
+    size_t capacity;
+} oid_list;
+
+/* Doubles as the callback of the walks */
+int oid_list_push(const git_oid *oid, void *payload);
+/* Same commits in any order, and none of them twice. Sorts both lists */
+bool oid_list_same(oid_list *a, oid_list *b);
+void oid_list_clear(oid_list *list);
+
+/* since and resume of the ranges the walks get checked on, either can be NULL */
+extern const char *fixture_ranges[][2];
+extern const size_t fixture_range_count;
+
+/* Reports the failed checks. Returns the exit code of the test */
+int test_report(const char *name);
+
+/* Takes <make_fixture.sh> <scratch dir> from the command line, builds the fixture in <scratch dir>/fixture and opens it.
+ * Exits with 2 if any of it does not work out */
+git_repository *fixture_open(int argc, char *argv[]);
+/* Frees the repository and reports, see test_report */
+int fixture_finish(git_repository *repository, const char *name);
+/* The commit a revision points at, exits with 2 if there is none */
+git_oid fixture_resolve(git_repository *repository, const char *spec);
+/* The plain revwalk every reader has to agree with */
+void fixture_revwalk(oid_list *out, git_repository *repository, const git_oid *head, const git_oid *since, const git_oid *resume, bool first_parent);
+/* The first pack of the fixture, NULL if it has none */
+corel_pack *fixture_pack(git_repository *repository);
+
+#endif